@@ -6,6 +6,24 @@
 #include <string>
 #include <sstream>
 #include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+
+#include "PreviewServer.h"
+#include "ParameterSweep.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 using namespace std;
 
@@ -18,6 +36,95 @@ const int PIXEL_BUFFER_SIZE = FRAME_WIDTH * FRAME_HEIGHT * 3;
 
 const bool SAVE_FRAMES = true;
 
+// STORE FRAMES IN ONE MEMORY MAPPED CONTAINER INSTEAD OF frame_N.bmp FILES
+const bool USE_FRAME_CONTAINER = true;
+const string FRAME_CONTAINER_PATH = "./output/frames.mbfc";
+
+// BITMAP ROWS ARE PADDED TO 4 BYTES, SLOTS ARE PADDED TO A PAGE
+const int BITMAP_ROW_SIZE = (FRAME_WIDTH * 3 + 3) & ~3;
+const int BITMAP_PIXEL_SIZE = BITMAP_ROW_SIZE * FRAME_HEIGHT;
+const uint64_t FRAME_SLOT_ALIGNMENT = 4096;
+
+// RENDER EVERY DISTINCT SET OF SHADER PARAMETERS ONCE, REPEATS LINK TO THE FIRST RENDER
+// Parameters are compared on a grid of FRAME_CACHE_QUANTUM (0 = bit exact)
+const bool USE_FRAME_CACHE = true;
+const float FRAME_CACHE_QUANTUM = 0.0001f;
+
+// DENOISED DOF: FEW LOW DISCREPANCY SAMPLES + EDGE-AVOIDING A-TROUS PASSES
+// UNVALIDATED: never compiled or run on a GPU. Off by default, the full NUM_SAMPLES render
+// stays the reference until COMPARE_TO_REFERENCE has shown the PSNR / SSIM and timings
+// are good enough for the animation
+const bool USE_DENOISE = false;
+const int DENOISE_SAMPLES = 8;
+const int DENOISE_PASSES = 4;
+
+// ALSO RENDER A REFERENCE_SAMPLES FRAME WITHOUT DENOISING AND PRINT PSNR / SSIM
+const bool COMPARE_TO_REFERENCE = false;
+const int REFERENCE_SAMPLES = 50;
+
+// ALSO SAVE A MARCH STEP HEATMAP PER FRAME AND PRINT STEPS / ESCAPE ITERATIONS WITH LOD OFF AND ON
+const bool SAVE_STEP_HEATMAP = false;
+const float HEATMAP_MAX_STEPS = 200.0f;
+
+// ALSO MARCH EVERY FRAME PLAIN AND OVER-RELAXED, PRINT STEPS AND PSNR / SSIM BETWEEN THEM
+const bool COMPARE_RELAXATION = false;
+const float COMPARE_RELAXATION_FACTOR = 1.6f;
+
+// STREAM THE RENDER TO http://127.0.0.1:PREVIEW_PORT (SEE PreviewServer.h)
+const bool USE_PREVIEW_SERVER = false;
+const int PREVIEW_PORT = 8080;
+
+// PARAMETER SWEEP CONTACT SHEET WRITTEN BY "Application sweep" (GRID IN ParameterSweep.h)
+const string SWEEP_IMAGE_PATH = "./output/sweep.bmp";
+const string SWEEP_INDEX_PATH = "./output/sweep.json";
+
+// ONLY SHADE THE SCREEN RECTANGLE COVERED BY THE BOUNDING SPHERE OF THE SET
+const bool USE_BOUND_CULLING = true;
+const float BOUND_RADIUS = 2.0f;
+
+// ALSO TIME EVERY FRAME WITHOUT / WITH CULLING AND PRINT THE CULLED FRACTION AND SPEEDUP
+const bool REPORT_CULLING = false;
+
+// CAMERA SETTINGS (MUST MATCH res/shaders/Basic.frag)
+const float TIME_SCALE = 1.0f;
+const float TIME_OFFSET = 5.616f;
+const float FOV = 12.0f;
+const float FOCAL_LENGTH = 2.920f;
+const float APERTURE = 0.024f;
+
+struct vec3 {
+    float x;
+    float y;
+    float z;
+};
+
+vec3 add(const vec3& a, const vec3& b) {
+    return { a.x + b.x, a.y + b.y, a.z + b.z };
+}
+vec3 sub(const vec3& a, const vec3& b) {
+    return { a.x - b.x, a.y - b.y, a.z - b.z };
+}
+vec3 scale(const vec3& a, float s) {
+    return { a.x * s, a.y * s, a.z * s };
+}
+float dot(const vec3& a, const vec3& b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+vec3 cross(const vec3& a, const vec3& b) {
+    vec3 result;
+    result.x = a.y * b.z - a.z * b.y;
+    result.y = a.z * b.x - a.x * b.z;
+    result.z = a.x * b.y - a.y * b.x;
+    return result;
+}
+float length(const vec3& a) {
+    return sqrt(a.x * a.x + a.y * a.y + a.z * a.z);
+}
+vec3 normalize(const vec3& a) {
+    float len = length(a);
+    return { a.x / len, a.y / len, a.z / len };
+}
+
 struct ShaderProgramSource {
     string VertexSource;
     string FragmentSource;
@@ -93,7 +200,7 @@ static unsigned int CreateShader(const string& vertexShader, const string& fragm
     return program;
 }
 
-void save_bitmap(const string& filename, GLubyte* imageData)
+void write_bitmap_headers(ofstream& file, int width, int height)
 {
     // Define the bitmap file header
     unsigned char bitmapFileHeader[14] = {
@@ -119,10 +226,10 @@ void save_bitmap(const string& filename, GLubyte* imageData)
     };
 
     // Calculate the padding bytes
-    int paddingSize = (4 - (FRAME_WIDTH * 3) % 4) % 4;
+    int paddingSize = (4 - (width * 3) % 4) % 4;
 
     // Calculate the file size
-    int fileSize = 54 + (FRAME_WIDTH * FRAME_HEIGHT * 3) + (paddingSize * FRAME_HEIGHT);
+    int fileSize = 54 + (width * height * 3) + (paddingSize * height);
 
     // Fill in the file size in the bitmap file header
     bitmapFileHeader[2] = (unsigned char)(fileSize);
@@ -131,23 +238,31 @@ void save_bitmap(const string& filename, GLubyte* imageData)
     bitmapFileHeader[5] = (unsigned char)(fileSize >> 24);
 
     // Fill in the image width in the bitmap info header
-    bitmapInfoHeader[4] = (unsigned char)(FRAME_WIDTH);
-    bitmapInfoHeader[5] = (unsigned char)(FRAME_WIDTH >> 8);
-    bitmapInfoHeader[6] = (unsigned char)(FRAME_WIDTH >> 16);
-    bitmapInfoHeader[7] = (unsigned char)(FRAME_WIDTH >> 24);
+    bitmapInfoHeader[4] = (unsigned char)(width);
+    bitmapInfoHeader[5] = (unsigned char)(width >> 8);
+    bitmapInfoHeader[6] = (unsigned char)(width >> 16);
+    bitmapInfoHeader[7] = (unsigned char)(width >> 24);
 
     // Fill in the image height in the bitmap info header
-    bitmapInfoHeader[8] = (unsigned char)(FRAME_HEIGHT);
-    bitmapInfoHeader[9] = (unsigned char)(FRAME_HEIGHT >> 8);
-    bitmapInfoHeader[10] = (unsigned char)(FRAME_HEIGHT >> 16);
-    bitmapInfoHeader[11] = (unsigned char)(FRAME_HEIGHT >> 24);
+    bitmapInfoHeader[8] = (unsigned char)(height);
+    bitmapInfoHeader[9] = (unsigned char)(height >> 8);
+    bitmapInfoHeader[10] = (unsigned char)(height >> 16);
+    bitmapInfoHeader[11] = (unsigned char)(height >> 24);
+
+    // Write the bitmap headers
+    file.write(reinterpret_cast<const char*>(bitmapFileHeader), sizeof(bitmapFileHeader));
+    file.write(reinterpret_cast<const char*>(bitmapInfoHeader), sizeof(bitmapInfoHeader));
+}
+void save_bitmap(const string& filename, GLubyte* imageData)
+{
+    // Calculate the padding bytes
+    int paddingSize = (4 - (FRAME_WIDTH * 3) % 4) % 4;
 
     // Open the output file
     ofstream file(filename, ios::binary);
 
     // Write the bitmap headers
-    file.write(reinterpret_cast<const char*>(bitmapFileHeader), sizeof(bitmapFileHeader));
-    file.write(reinterpret_cast<const char*>(bitmapInfoHeader), sizeof(bitmapInfoHeader));
+    write_bitmap_headers(file, FRAME_WIDTH, FRAME_HEIGHT);
 
     // Write the pixel data (BGR format) row by row
     for (int y = FRAME_HEIGHT - 1; y >= 0; y--)
@@ -191,6 +306,712 @@ void save_frame(const string& filename, GLubyte* pixels)
     delete[] pixels;
 }
 
+// FRAME CONTAINER LAYOUT: HEADER | INDEX (ONE ENTRY PER FRAME) | FRAME SLOTS
+// Every slot holds the pixel array of a 24-bit bitmap (BGR, bottom-up rows
+// padded to 4 bytes), which is exactly what glReadPixels produces with
+// GL_BGR and the default pack alignment, so frames are read back straight
+// into the mapping and extracted with a single write.
+struct FrameContainerHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t frame_count;
+    uint32_t frame_size;
+    uint64_t frame_stride;
+    uint64_t index_offset;
+    uint64_t data_offset;
+};
+
+struct FrameIndexEntry {
+    uint64_t offset;
+    float time;
+    uint32_t written;
+};
+
+struct FrameContainer {
+    unsigned char* data = nullptr;
+    uint64_t size = 0;
+    FrameContainerHeader* header = nullptr;
+    FrameIndexEntry* index = nullptr;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
+#else
+    int file = -1;
+#endif
+};
+
+uint64_t align_up(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+void close_frame_container(FrameContainer& container)
+{
+#ifdef _WIN32
+    if (container.data)
+        UnmapViewOfFile(container.data);
+    if (container.mapping)
+        CloseHandle(container.mapping);
+    if (container.file != INVALID_HANDLE_VALUE)
+        CloseHandle(container.file);
+    container.file = INVALID_HANDLE_VALUE;
+    container.mapping = NULL;
+#else
+    if (container.data)
+        munmap(container.data, container.size);
+    if (container.file >= 0)
+        close(container.file);
+    container.file = -1;
+#endif
+    container.data = nullptr;
+    container.header = nullptr;
+    container.index = nullptr;
+    container.size = 0;
+}
+
+// MAP A CONTAINER FILE, CREATING AND PREALLOCATING IT WHEN frame_count > 0
+bool open_frame_container(FrameContainer& container, const string& filename, int frame_count)
+{
+    bool create = frame_count > 0;
+
+    uint64_t index_offset = align_up(sizeof(FrameContainerHeader), 8);
+    uint64_t data_offset = align_up(index_offset + sizeof(FrameIndexEntry) * (uint64_t)max(frame_count, 0), FRAME_SLOT_ALIGNMENT);
+    uint64_t frame_stride = align_up(BITMAP_PIXEL_SIZE, FRAME_SLOT_ALIGNMENT);
+
+    if (create)
+        container.size = data_offset + frame_stride * (uint64_t)frame_count;
+
+#ifdef _WIN32
+    container.file = CreateFileA(filename.c_str(), create ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ, FILE_SHARE_READ, NULL, create ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (container.file == INVALID_HANDLE_VALUE)
+        return false;
+
+    if (create)
+    {
+        // Allocate the whole file now so a full disk fails here, not midway through the render
+        LARGE_INTEGER file_size;
+        file_size.QuadPart = (LONGLONG)container.size;
+        if (!SetFilePointerEx(container.file, file_size, NULL, FILE_BEGIN) || !SetEndOfFile(container.file))
+        {
+            close_frame_container(container);
+            return false;
+        }
+    }
+    else
+    {
+        LARGE_INTEGER file_size;
+        GetFileSizeEx(container.file, &file_size);
+        container.size = (uint64_t)file_size.QuadPart;
+    }
+
+    container.mapping = CreateFileMappingA(container.file, NULL, create ? PAGE_READWRITE : PAGE_READONLY, (DWORD)(container.size >> 32), (DWORD)container.size, NULL);
+    if (!container.mapping)
+    {
+        close_frame_container(container);
+        return false;
+    }
+    container.data = (unsigned char*)MapViewOfFile(container.mapping, create ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+#else
+    container.file = open(filename.c_str(), create ? O_RDWR | O_CREAT | O_TRUNC : O_RDONLY, 0644);
+    if (container.file < 0)
+        return false;
+
+    if (create)
+    {
+        // Allocate the whole file now so a full disk fails here, not as SIGBUS midway through the render
+        if (posix_fallocate(container.file, 0, (off_t)container.size) != 0)
+        {
+            close_frame_container(container);
+            return false;
+        }
+    }
+    else
+    {
+        struct stat file_stat;
+        fstat(container.file, &file_stat);
+        container.size = (uint64_t)file_stat.st_size;
+    }
+
+    void* data = mmap(nullptr, container.size, create ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, container.file, 0);
+    container.data = data == MAP_FAILED ? nullptr : (unsigned char*)data;
+#endif
+    if (!container.data || container.size < sizeof(FrameContainerHeader))
+    {
+        close_frame_container(container);
+        return false;
+    }
+
+    container.header = (FrameContainerHeader*)container.data;
+
+    if (create)
+    {
+        // Write the header and an empty index, the slots stay untouched
+        FrameContainerHeader* header = container.header;
+        memcpy(header->magic, "MBFC", 4);
+        header->version = 1;
+        header->width = FRAME_WIDTH;
+        header->height = FRAME_HEIGHT;
+        header->frame_count = frame_count;
+        header->frame_size = BITMAP_PIXEL_SIZE;
+        header->frame_stride = frame_stride;
+        header->index_offset = index_offset;
+        header->data_offset = data_offset;
+
+        container.index = (FrameIndexEntry*)(container.data + index_offset);
+        for (int i = 0; i < frame_count; i++)
+            container.index[i] = { data_offset + frame_stride * i, 0.0f, 0 };
+    }
+    else
+    {
+        // Validate the header before trusting any offsets or sizes
+        FrameContainerHeader* header = container.header;
+        uint64_t row_size = ((uint64_t)header->width * 3 + 3) & ~(uint64_t)3;
+        bool valid = memcmp(header->magic, "MBFC", 4) == 0 && header->version == 1 &&
+            header->width > 0 && header->height > 0 &&
+            header->frame_size == row_size * header->height &&
+            header->frame_size <= header->frame_stride &&
+            header->index_offset <= container.size &&
+            (uint64_t)header->frame_count <= (container.size - header->index_offset) / sizeof(FrameIndexEntry) &&
+            header->data_offset <= container.size &&
+            (header->frame_count == 0 || header->frame_stride <= (container.size - header->data_offset) / header->frame_count);
+        if (!valid)
+        {
+            close_frame_container(container);
+            return false;
+        }
+        container.index = (FrameIndexEntry*)(container.data + header->index_offset);
+    }
+
+    return true;
+}
+
+// GET THE PIXEL SLOT OF A FRAME, NO PARSING NEEDED
+// Cached repeats point their index entry at the slot of the first render
+GLubyte* frame_slot(FrameContainer& container, int frame)
+{
+    return container.data + container.index[frame].offset;
+}
+
+// WRITE ONE CONTAINER SLOT OUT AS A BITMAP FILE
+bool extract_frame(FrameContainer& container, int frame, const string& filename)
+{
+    if (frame < 0 || frame >= (int)container.header->frame_count || !container.index[frame].written)
+        return false;
+    if (container.index[frame].offset + container.header->frame_size > container.size)
+        return false;
+
+    ofstream file(filename, ios::binary);
+    write_bitmap_headers(file, container.header->width, container.header->height);
+    file.write(reinterpret_cast<const char*>(frame_slot(container, frame)), container.header->frame_size);
+    file.close();
+
+    return true;
+}
+
+// EXTRACT FRAMES FROM A CONTAINER: ALL WRITTEN FRAMES OR THE GIVEN INDICES
+int extract_frames(int argc, char** argv)
+{
+    FrameContainer container;
+    if (!open_frame_container(container, FRAME_CONTAINER_PATH, 0))
+    {
+        cout << "FAILED TO OPEN " << FRAME_CONTAINER_PATH << endl;
+        return -1;
+    }
+
+    int frame_count = (int)container.header->frame_count;
+    int extracted = 0;
+
+    if (argc > 2)
+    {
+        for (int i = 2; i < argc; i++)
+        {
+            int frame = atoi(argv[i]);
+            if (extract_frame(container, frame, "./output/frame_" + to_string(frame) + ".bmp"))
+                extracted++;
+            else
+                cout << "FRAME " << frame << " NOT IN CONTAINER" << endl;
+        }
+    }
+    else
+    {
+        for (int i = 0; i < frame_count; i++)
+        {
+            if (extract_frame(container, i, "./output/frame_" + to_string(i) + ".bmp"))
+                extracted++;
+        }
+    }
+
+    cout << "EXTRACTED: " << extracted << " FRAME(S)" << endl;
+
+    close_frame_container(container);
+    return 0;
+}
+
+// SHADER PARAMETERS OF ONE FRAME, COMPUTED ON THE CPU
+struct FrameParameters {
+    float power;
+    vec3 camera_position;
+    vec3 target;
+    // Distance to the DOF focal point along each pixel ray
+    float focus_distance;
+    // Camera basis: a pixel at uv looks along forward + (right * uv.x + up * uv.y) * tan_half_fov
+    vec3 right;
+    vec3 up;
+    vec3 forward;
+    float tan_half_fov;
+};
+
+// ROTATE VECTOR BY ANGLE AROUND AXIS (SAME AS rotate_vector IN THE SHADER)
+vec3 rotate_vector(const vec3& vector, const vec3& axis, float angle)
+{
+    vec3 normalized_axis = normalize(axis);
+    float cos_theta = cos(angle);
+    float sin_theta = sin(angle);
+    vec3 crossed = cross(vector, normalized_axis);
+    float dotted = dot(vector, normalized_axis);
+    return add(add(scale(vector, cos_theta), scale(crossed, sin_theta)), scale(normalized_axis, dotted * (1.0f - cos_theta)));
+}
+
+// CPU PORT OF THE CAMERA / POWER SETUP IN res/shaders/Basic.frag
+FrameParameters compute_frame_parameters(float time_value)
+{
+    FrameParameters params;
+
+    float wave = sin(time_value * 0.132f * TIME_SCALE + TIME_OFFSET);
+    params.power = ((wave + 1.0f) / 2.0f) * 11.640f + 4.0f;
+
+    float size = FOCAL_LENGTH;
+    float t = -1.592f + wave * 0.8f;
+    params.target = { cos(-1.592f), 0.0f, sin(-1.592f) };
+    params.camera_position = add({ size * cos(t), 0.0f, size * sin(t) }, params.target);
+    params.focus_distance = FOCAL_LENGTH;
+
+    // The shader rotates +z onto the view direction
+    vec3 z_axis = { 0.0f, 0.0f, 1.0f };
+    vec3 view = normalize(sub(params.target, params.camera_position));
+    vec3 axis = cross(z_axis, view);
+    float theta = -acos(min(max(dot(z_axis, view), -1.0f), 1.0f));
+    if (length(axis) < 1e-6f) {
+        params.right = { 1.0f, 0.0f, 0.0f };
+        params.up = { 0.0f, 1.0f, 0.0f };
+        params.forward = z_axis;
+    }
+    else {
+        params.right = rotate_vector({ 1.0f, 0.0f, 0.0f }, axis, theta);
+        params.up = rotate_vector({ 0.0f, 1.0f, 0.0f }, axis, theta);
+        params.forward = rotate_vector(z_axis, axis, theta);
+    }
+
+    params.tan_half_fov = tan(FOV * (3.141f / 180.0f) * 0.5f);
+    return params;
+}
+
+// QUANTIZED SHADER PARAMETERS THAT DECIDE THE CONTENT OF A FRAME
+struct FrameCacheKey {
+    int64_t values[8];
+};
+
+FrameCacheKey frame_cache_key(const FrameParameters& params)
+{
+    float raw[8] = {
+        params.power,
+        params.camera_position.x, params.camera_position.y, params.camera_position.z,
+        params.target.x, params.target.y, params.target.z,
+        params.focus_distance
+    };
+
+    FrameCacheKey key;
+    for (int i = 0; i < 8; i++) {
+        if (FRAME_CACHE_QUANTUM > 0.0f) {
+            key.values[i] = (int64_t)llround((double)raw[i] / FRAME_CACHE_QUANTUM);
+        }
+        else {
+            // Bit exact, with -0 folded into 0
+            float value = raw[i] + 0.0f;
+            uint32_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            key.values[i] = bits;
+        }
+    }
+    return key;
+}
+
+// FNV-1a OVER THE KEY BYTES
+uint64_t frame_cache_hash(const FrameCacheKey& key)
+{
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(key.values);
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < sizeof(key.values); i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// CONTENT ADDRESSED CACHE: KEY HASH -> FIRST FRAME RENDERED WITH THAT KEY
+struct FrameCache {
+    unordered_map<uint64_t, pair<FrameCacheKey, int>> entries;
+};
+
+// RETURN THE FRAME THAT ALREADY HOLDS THIS CONTENT, OR ADD frame AND RETURN IT
+int lookup_frame_cache(FrameCache& cache, const FrameCacheKey& key, int frame)
+{
+    uint64_t hash = frame_cache_hash(key);
+    unordered_map<uint64_t, pair<FrameCacheKey, int>>::iterator entry = cache.entries.find(hash);
+    if (entry == cache.entries.end()) {
+        cache.entries[hash] = { key, frame };
+        return frame;
+    }
+
+    // A hash collision with different parameters is simply rendered again
+    if (memcmp(entry->second.first.values, key.values, sizeof(key.values)) != 0)
+        return frame;
+    return entry->second.second;
+}
+
+// EMIT A CACHED FRAME FILE AS A HARD LINK TO ITS SOURCE, COPY WHERE LINKS ARE NOT SUPPORTED
+void link_frame(const string& source, const string& filename)
+{
+#ifdef _WIN32
+    DeleteFileA(filename.c_str());
+    bool linked = CreateHardLinkA(filename.c_str(), source.c_str(), NULL) != 0;
+#else
+    unlink(filename.c_str());
+    bool linked = link(source.c_str(), filename.c_str()) == 0;
+#endif
+    if (linked)
+        return;
+
+    ifstream in(source, ios::binary);
+    if (in) {
+        ofstream out(filename, ios::binary | ios::trunc);
+        if (out << in.rdbuf())
+            return;
+    }
+    cout << "FAILED TO LINK " << filename << " TO " << source << endl;
+}
+
+struct ScreenRect {
+    int x;
+    int y;
+    int width;
+    int height;
+};
+
+// RANGE OF uv ALONG ONE SCREEN AXIS COVERED BY A SPHERE (c = CENTER ALONG THAT AXIS, cz = DEPTH)
+// Returns false when the sphere crosses the camera plane and the range is unbounded
+bool sphere_uv_range(float c, float cz, float radius, float tan_half_fov, float& uv_min, float& uv_max)
+{
+    float a = cz * cz - radius * radius;
+    if (cz <= 0.0f || a <= 0.0f)
+        return false;
+
+    // Slopes m = c / cz of the two lines through the eye tangent to the circle
+    float root = radius * sqrt(c * c + a);
+    uv_min = (c * cz - root) / a / tan_half_fov;
+    uv_max = (c * cz + root) / a / tan_half_fov;
+    return true;
+}
+
+// SCISSOR RECTANGLE THAT CONTAINS EVERY PIXEL WHOSE RAYS CAN REACH THE BOUNDING SPHERE
+ScreenRect project_bounding_sphere(const FrameParameters& params)
+{
+    ScreenRect full = { 0, 0, FRAME_WIDTH, FRAME_HEIGHT };
+
+    // DOF rays leave up to one aperture corner away from the pinhole ray
+    vec3 to_center = sub({ 0.0f, 0.0f, 0.0f }, params.camera_position);
+    float distance = length(to_center);
+    float aperture_spread = APERTURE * sqrt(2.0f) * max(1.0f, (distance + BOUND_RADIUS) / FOCAL_LENGTH);
+    float radius = BOUND_RADIUS + aperture_spread;
+
+    if (distance <= radius)
+        return full;
+
+    float cx = dot(to_center, params.right);
+    float cy = dot(to_center, params.up);
+    float cz = dot(to_center, params.forward);
+
+    // Entirely behind the camera
+    if (cz < -radius)
+        return { 0, 0, 0, 0 };
+
+    float u_min = -1.0f, u_max = 1.0f, v_min = -1.0f, v_max = 1.0f;
+    if (!sphere_uv_range(cx, cz, radius, params.tan_half_fov, u_min, u_max) ||
+        !sphere_uv_range(cy, cz, radius, params.tan_half_fov, v_min, v_max))
+        return full;
+
+    // uv spans -1..1 over the frame, pad one pixel for rasterization
+    int x0 = max((int)floor((u_min + 1.0f) * 0.5f * FRAME_WIDTH) - 1, 0);
+    int x1 = min((int)ceil((u_max + 1.0f) * 0.5f * FRAME_WIDTH) + 1, FRAME_WIDTH);
+    int y0 = max((int)floor((v_min + 1.0f) * 0.5f * FRAME_HEIGHT) - 1, 0);
+    int y1 = min((int)ceil((v_max + 1.0f) * 0.5f * FRAME_HEIGHT) + 1, FRAME_HEIGHT);
+    if (x1 <= x0 || y1 <= y0)
+        return { 0, 0, 0, 0 };
+
+    return { x0, y0, x1 - x0, y1 - y0 };
+}
+
+struct RenderPipeline {
+    unsigned int shader;
+    int time_location;
+    int samples_location;
+    int resolution_location;
+    int exact_location;
+    int lod_location;
+    int heatmap_location;
+    int relaxation_location;
+    int unbounded_location;
+
+    unsigned int denoise_shader;
+    int color_location;
+    int guide_location;
+    int step_width_location;
+
+    unsigned int scene_fbo;
+    unsigned int scene_color;
+    unsigned int scene_guide;
+    unsigned int pass_fbo[2];
+    unsigned int pass_color[2];
+
+    unsigned int timer_queries[DENOISE_PASSES + 1];
+
+    unsigned int heatmap_fbo;
+    unsigned int heatmap_texture;
+
+    bool use_scissor;
+    ScreenRect scissor;
+};
+
+struct HeatmapStats {
+    double mean_steps;
+    float max_steps;
+    double mean_escape_iters;
+};
+
+unsigned int create_render_texture(GLenum internal_format)
+{
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, internal_format, FRAME_WIDTH, FRAME_HEIGHT, 0, GL_RGBA, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    return texture;
+}
+
+unsigned int create_framebuffer(unsigned int color, unsigned int guide)
+{
+    unsigned int fbo;
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color, 0);
+
+    if (guide) {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, guide, 0);
+        GLenum draw_buffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+        glDrawBuffers(2, draw_buffers);
+    }
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        cout << "FRAMEBUFFER INCOMPLETE!" << endl;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return fbo;
+}
+
+// BIND AND CLEAR A TARGET, THEN RESTRICT DRAWING TO THE CULLING RECTANGLE
+void begin_pass(const RenderPipeline& pipeline, unsigned int fbo)
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glDisable(GL_SCISSOR_TEST);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    if (pipeline.use_scissor) {
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(pipeline.scissor.x, pipeline.scissor.y, pipeline.scissor.width, pipeline.scissor.height);
+    }
+}
+
+// RENDER ONE FRAME INTO THE DEFAULT FRAMEBUFFER, OPTIONALLY THROUGH THE DENOISER
+void render_frame(const RenderPipeline& pipeline, float time_value, int samples, bool denoise)
+{
+    glUseProgram(pipeline.shader);
+    glUniform1f(pipeline.time_location, time_value);
+    glUniform1i(pipeline.samples_location, samples);
+
+    if (!denoise) {
+        begin_pass(pipeline, 0);
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+        glDisable(GL_SCISSOR_TEST);
+        return;
+    }
+
+    // MARCH INTO COLOR + GUIDE (DEPTH / STEPS) TEXTURES
+    glBeginQuery(GL_TIME_ELAPSED, pipeline.timer_queries[0]);
+    begin_pass(pipeline, pipeline.scene_fbo);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    glEndQuery(GL_TIME_ELAPSED);
+
+    glUseProgram(pipeline.denoise_shader);
+    glUniform1i(pipeline.color_location, 0);
+    glUniform1i(pipeline.guide_location, 1);
+
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, pipeline.scene_guide);
+
+    // PING-PONG A-TROUS PASSES, THE LAST ONE WRITES THE DEFAULT FRAMEBUFFER
+    unsigned int input = pipeline.scene_color;
+    for (int i = 0; i < DENOISE_PASSES; i++) {
+        bool last = i == DENOISE_PASSES - 1;
+        begin_pass(pipeline, last ? 0 : pipeline.pass_fbo[i % 2]);
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, input);
+        glUniform1i(pipeline.step_width_location, 1 << i);
+
+        glBeginQuery(GL_TIME_ELAPSED, pipeline.timer_queries[i + 1]);
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+        glEndQuery(GL_TIME_ELAPSED);
+
+        input = pipeline.pass_color[i % 2];
+    }
+    glDisable(GL_SCISSOR_TEST);
+}
+
+// SET THE SPHERE TRACING RELAXATION (1 = PLAIN, 0 = SHADER DEFAULT)
+void set_relaxation(const RenderPipeline& pipeline, float relaxation)
+{
+    glUseProgram(pipeline.shader);
+    glUniform1f(pipeline.relaxation_location, relaxation);
+}
+
+// FORCE LOD ON REGARDLESS OF USE_LOD IN THE SHADER
+void set_lod(const RenderPipeline& pipeline, bool force)
+{
+    glUseProgram(pipeline.shader);
+    glUniform1i(pipeline.lod_location, force ? 1 : 0);
+}
+
+// TOGGLE THE BOUNDING SPHERE RAY ENTRY IN THE SHADER
+void set_unbounded(const RenderPipeline& pipeline, bool unbounded)
+{
+    glUseProgram(pipeline.shader);
+    glUniform1i(pipeline.unbounded_location, unbounded ? 1 : 0);
+}
+
+// RENDER RAW PER PIXEL MARCH STEPS / ESCAPE ITERATIONS INTO values (RGBA FLOAT)
+HeatmapStats render_heatmap(const RenderPipeline& pipeline, float time_value, int samples, bool exact, float* values)
+{
+    glUseProgram(pipeline.shader);
+    glUniform1f(pipeline.time_location, time_value);
+    glUniform1i(pipeline.samples_location, samples);
+    glUniform1i(pipeline.exact_location, exact ? 1 : 0);
+    glUniform1i(pipeline.heatmap_location, 1);
+
+    begin_pass(pipeline, pipeline.heatmap_fbo);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    glDisable(GL_SCISSOR_TEST);
+    glReadPixels(0, 0, FRAME_WIDTH, FRAME_HEIGHT, GL_RGBA, GL_FLOAT, values);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    glUniform1i(pipeline.exact_location, 0);
+    glUniform1i(pipeline.heatmap_location, 0);
+
+    HeatmapStats stats = { 0.0, 0.0f, 0.0 };
+    for (int i = 0; i < FRAME_WIDTH * FRAME_HEIGHT; i++) {
+        stats.mean_steps += values[i * 4];
+        stats.max_steps = max(stats.max_steps, values[i * 4]);
+        stats.mean_escape_iters += values[i * 4 + 1];
+    }
+    stats.mean_steps /= FRAME_WIDTH * FRAME_HEIGHT;
+    stats.mean_escape_iters /= FRAME_WIDTH * FRAME_HEIGHT;
+    return stats;
+}
+
+// MAP MARCH STEPS TO BLACK -> BLUE -> RED -> YELLOW
+GLubyte* heatmap_pixels(const float* values)
+{
+    GLubyte* pixels = new GLubyte[PIXEL_BUFFER_SIZE];
+    for (int i = 0; i < FRAME_WIDTH * FRAME_HEIGHT; i++) {
+        float t = min(values[i * 4] / HEATMAP_MAX_STEPS, 1.0f);
+        float r = min(max(t * 3.0f - 1.0f, 0.0f), 1.0f);
+        float g = min(max(t * 3.0f - 2.0f, 0.0f), 1.0f);
+        float b = t < 1.0f / 3.0f ? t * 3.0f : max(2.0f - t * 3.0f, 0.0f);
+        pixels[i * 3] = (GLubyte)(r * 255.0f);
+        pixels[i * 3 + 1] = (GLubyte)(g * 255.0f);
+        pixels[i * 3 + 2] = (GLubyte)(b * 255.0f);
+    }
+    return pixels;
+}
+
+// GPU TIME OF THE MARCH PASS AND EVERY DENOISE PASS IN MILLISECONDS
+string pass_timings(const RenderPipeline& pipeline)
+{
+    stringstream ss;
+    for (int i = 0; i < DENOISE_PASSES + 1; i++) {
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(pipeline.timer_queries[i], GL_QUERY_RESULT, &elapsed);
+        ss << (i == 0 ? "MARCH: " : i == 1 ? " | DENOISE: " : ", ") << (float)elapsed / 1000000.0f << "ms";
+    }
+    return ss.str();
+}
+
+// PEAK SIGNAL TO NOISE RATIO OF TWO RGB FRAMES IN DB
+float compute_psnr(const GLubyte* a, const GLubyte* b)
+{
+    double squared_error = 0.0;
+    for (int i = 0; i < PIXEL_BUFFER_SIZE; i++) {
+        double delta = (double)a[i] - (double)b[i];
+        squared_error += delta * delta;
+    }
+    double mse = squared_error / (double)PIXEL_BUFFER_SIZE;
+    if (mse == 0.0)
+        return 99.0f;
+    return (float)(10.0 * log10(255.0 * 255.0 / mse));
+}
+
+// MEAN STRUCTURAL SIMILARITY OF TWO RGB FRAMES OVER 8x8 LUMA WINDOWS
+float compute_ssim(const GLubyte* a, const GLubyte* b)
+{
+    const double c1 = (0.01 * 255.0) * (0.01 * 255.0);
+    const double c2 = (0.03 * 255.0) * (0.03 * 255.0);
+
+    double ssim_sum = 0.0;
+    int windows = 0;
+    for (int wy = 0; wy + 8 <= FRAME_HEIGHT; wy += 8) {
+        for (int wx = 0; wx + 8 <= FRAME_WIDTH; wx += 8) {
+            double mean_a = 0.0, mean_b = 0.0, var_a = 0.0, var_b = 0.0, covar = 0.0;
+            double luma_a[64], luma_b[64];
+            for (int i = 0; i < 64; i++) {
+                int position = ((wy + i / 8) * FRAME_WIDTH + wx + i % 8) * 3;
+                luma_a[i] = 0.299 * a[position] + 0.587 * a[position + 1] + 0.114 * a[position + 2];
+                luma_b[i] = 0.299 * b[position] + 0.587 * b[position + 1] + 0.114 * b[position + 2];
+                mean_a += luma_a[i];
+                mean_b += luma_b[i];
+            }
+            mean_a /= 64.0;
+            mean_b /= 64.0;
+            for (int i = 0; i < 64; i++) {
+                var_a += (luma_a[i] - mean_a) * (luma_a[i] - mean_a);
+                var_b += (luma_b[i] - mean_b) * (luma_b[i] - mean_b);
+                covar += (luma_a[i] - mean_a) * (luma_b[i] - mean_b);
+            }
+            var_a /= 63.0;
+            var_b /= 63.0;
+            covar /= 63.0;
+
+            ssim_sum += ((2.0 * mean_a * mean_b + c1) * (2.0 * covar + c2)) /
+                        ((mean_a * mean_a + mean_b * mean_b + c1) * (var_a + var_b + c2));
+            windows++;
+        }
+    }
+    return (float)(ssim_sum / windows);
+}
+
 string sec_to_time(float time) 
 {
     float n_time = time;
@@ -215,8 +1036,90 @@ string sec_to_time(float time)
     return to_string(n_time) + suffix;
 }
 
-int main(void)
+// RENDER THE WHOLE PARAMETER SWEEP AS TILES OF ONE ATLAS: ONE DRAW CALL, ONE READBACK
+int render_sweep(const RenderPipeline& pipeline)
 {
+    vector<SweepParameters> grid = build_sweep_grid();
+    SweepLayout layout = sweep_layout((int)grid.size(), SWEEP_POWER_COUNT, SWEEP_TILE_SIZE);
+
+    int max_texture_size = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_texture_size);
+    if (layout.width > max_texture_size || layout.height > max_texture_size || (int)grid.size() > max_texture_size) {
+        cout << "SWEEP TOO LARGE: " << layout.width << "x" << layout.height << " (MAX " << max_texture_size << ")" << endl;
+        return -1;
+    }
+
+    cout << "RENDERING SWEEP: " << grid.size() << " TILE(S) OF " << layout.tile_width << "x" << layout.tile_height << " (" << layout.width << "x" << layout.height << ")" << endl;
+
+    chrono::system_clock::time_point start_time = chrono::system_clock::now();
+
+    // UPLOAD THE TILE PARAMETERS
+    vector<float> texels = sweep_texels(grid);
+    unsigned int params_texture;
+    glGenTextures(1, &params_texture);
+    glBindTexture(GL_TEXTURE_2D, params_texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, SWEEP_TEXELS_PER_TILE, (int)grid.size(), 0, GL_RGBA, GL_FLOAT, texels.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    // ATLAS TARGET
+    unsigned int atlas_texture;
+    glGenTextures(1, &atlas_texture);
+    glBindTexture(GL_TEXTURE_2D, atlas_texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, layout.width, layout.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    unsigned int atlas_fbo = create_framebuffer(atlas_texture, 0);
+
+    // u_resolution IS THE TILE SIZE SO THE LOD FOOTPRINT MATCHES THE TILE
+    glUseProgram(pipeline.shader);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, params_texture);
+    glUniform1i(glGetUniformLocation(pipeline.shader, "u_sweep_params"), 0);
+    glUniform1i(glGetUniformLocation(pipeline.shader, "u_sweep"), (int)grid.size());
+    glUniform2i(glGetUniformLocation(pipeline.shader, "u_sweep_grid"), layout.columns, layout.rows);
+    glUniform2f(pipeline.resolution_location, float(layout.tile_width), float(layout.tile_height));
+    glUniform1i(pipeline.samples_location, SWEEP_SAMPLES);
+    set_unbounded(pipeline, false);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, atlas_fbo);
+    glViewport(0, 0, layout.width, layout.height);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+
+    vector<unsigned char> pixels((size_t)layout.width * layout.height * 3);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, layout.width, layout.height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+    chrono::duration<float> duration = chrono::system_clock::now() - start_time;
+
+    // RESTORE THE FRAME SETUP
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, FRAME_WIDTH, FRAME_HEIGHT);
+    glUniform1i(glGetUniformLocation(pipeline.shader, "u_sweep"), 0);
+    glUniform2f(pipeline.resolution_location, float(FRAME_WIDTH), float(FRAME_HEIGHT));
+    glDeleteFramebuffers(1, &atlas_fbo);
+    glDeleteTextures(1, &atlas_texture);
+    glDeleteTextures(1, &params_texture);
+
+    if (!write_sweep_bitmap(SWEEP_IMAGE_PATH, pixels.data(), layout.width, layout.height) ||
+        !write_sweep_index(SWEEP_INDEX_PATH, SWEEP_IMAGE_PATH, "gpu", SWEEP_SAMPLES, duration.count(), grid, layout))
+    {
+        cout << "FAILED TO WRITE " << SWEEP_IMAGE_PATH << endl;
+        return -1;
+    }
+
+    cout << "SAVED: " << SWEEP_IMAGE_PATH << " + " << SWEEP_INDEX_PATH << endl;
+    cout << "Total time taken: " << sec_to_time(duration.count()) << endl;
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    // EXTRACT BITMAPS FROM THE FRAME CONTAINER WITHOUT RENDERING
+    if (argc > 1 && string(argv[1]) == "extract")
+        return extract_frames(argc, argv);
+
     GLFWwindow* window;
 
     // INITIALIZE THE LIBRARY
@@ -273,11 +1176,112 @@ int main(void)
     unsigned int shader = CreateShader(source.VertexSource, source.FragmentSource);
     glUseProgram(shader);
     
-    // INIT PARAM U_TIME
-    int timeLocation = glGetUniformLocation(shader, "u_time");
+    // INIT PARAM U_TIME / U_SAMPLES
+    RenderPipeline pipeline = {};
+    pipeline.shader = shader;
+    pipeline.time_location = glGetUniformLocation(shader, "u_time");
+    pipeline.samples_location = glGetUniformLocation(shader, "u_samples");
+    pipeline.resolution_location = glGetUniformLocation(shader, "u_resolution");
+    pipeline.exact_location = glGetUniformLocation(shader, "u_exact");
+    pipeline.lod_location = glGetUniformLocation(shader, "u_lod");
+    pipeline.heatmap_location = glGetUniformLocation(shader, "u_heatmap");
+    pipeline.relaxation_location = glGetUniformLocation(shader, "u_relaxation");
+    pipeline.unbounded_location = glGetUniformLocation(shader, "u_unbounded");
+
+    // PIXEL FOOTPRINT FOR LOD
+    glUniform2f(pipeline.resolution_location, float(FRAME_WIDTH), float(FRAME_HEIGHT));
+
+    // RENDER THE PARAMETER SWEEP INSTEAD OF THE ANIMATION
+    if (argc > 1 && string(argv[1]) == "sweep") {
+        int result = render_sweep(pipeline);
+        glfwTerminate();
+        return result;
+    }
+
+    // INIT DENOISER
+    if (USE_DENOISE) {
+        ShaderProgramSource denoise_source = ParseShader("res/shaders/Denoise.frag");
+        pipeline.denoise_shader = CreateShader(denoise_source.VertexSource, denoise_source.FragmentSource);
+        pipeline.color_location = glGetUniformLocation(pipeline.denoise_shader, "u_color");
+        pipeline.guide_location = glGetUniformLocation(pipeline.denoise_shader, "u_guide");
+        pipeline.step_width_location = glGetUniformLocation(pipeline.denoise_shader, "u_step_width");
+
+        pipeline.scene_color = create_render_texture(GL_RGBA16F);
+        pipeline.scene_guide = create_render_texture(GL_RGBA32F);
+        pipeline.scene_fbo = create_framebuffer(pipeline.scene_color, pipeline.scene_guide);
+        for (int i = 0; i < 2; i++) {
+            pipeline.pass_color[i] = create_render_texture(GL_RGBA16F);
+            pipeline.pass_fbo[i] = create_framebuffer(pipeline.pass_color[i], 0);
+        }
+
+        glGenQueries(DENOISE_PASSES + 1, pipeline.timer_queries);
+    }
+
+    // INIT REFERENCE COMPARISON
+    GLubyte* reference_pixels = COMPARE_TO_REFERENCE ? new GLubyte[PIXEL_BUFFER_SIZE] : nullptr;
+    GLubyte* compare_pixels = COMPARE_TO_REFERENCE ? new GLubyte[PIXEL_BUFFER_SIZE] : nullptr;
+    double psnr_sum = 0.0;
+    double ssim_sum = 0.0;
+
+    // INIT STEP HEATMAP
+    float* heatmap_values = nullptr;
+    HeatmapStats exact_sum = { 0.0, 0.0f, 0.0 };
+    HeatmapStats lod_sum = { 0.0, 0.0f, 0.0 };
+    HeatmapStats plain_sum = { 0.0, 0.0f, 0.0 };
+    HeatmapStats relaxed_sum = { 0.0, 0.0f, 0.0 };
+    double relaxation_psnr_sum = 0.0;
+    double relaxation_ssim_sum = 0.0;
+
+    // INIT RELAXATION COMPARISON (SEPARATE FROM THE REFERENCE, BOTH CAN RUN)
+    GLubyte* plain_pixels = COMPARE_RELAXATION ? new GLubyte[PIXEL_BUFFER_SIZE] : nullptr;
+    GLubyte* relaxed_pixels = COMPARE_RELAXATION ? new GLubyte[PIXEL_BUFFER_SIZE] : nullptr;
+
+    // INIT CULLING REPORT
+    pipeline.use_scissor = false;
+    pipeline.scissor = { 0, 0, FRAME_WIDTH, FRAME_HEIGHT };
+    double culled_sum = 0.0;
+    double unculled_time_sum = 0.0;
+    double culled_time_sum = 0.0;
+
+    if (SAVE_STEP_HEATMAP || COMPARE_RELAXATION) {
+        pipeline.heatmap_texture = create_render_texture(GL_RGBA32F);
+        pipeline.heatmap_fbo = create_framebuffer(pipeline.heatmap_texture, 0);
+        heatmap_values = new float[FRAME_WIDTH * FRAME_HEIGHT * 4];
+    }
 
     // INIT FRAME BUFFER
-    GLubyte** frame_buffer = new GLubyte*[MAX_FRAMES];
+    GLubyte** frame_buffer = nullptr;
+    FrameContainer container;
+
+    // INIT FRAME CACHE
+    FrameCache frame_cache;
+    int* frame_sources = new int[MAX_FRAMES];
+    int cached_frames = 0;
+
+    if (SAVE_FRAMES && USE_FRAME_CONTAINER) {
+        if (!open_frame_container(container, FRAME_CONTAINER_PATH, MAX_FRAMES)) {
+            cout << "FAILED TO CREATE " << FRAME_CONTAINER_PATH << endl;
+            glfwTerminate();
+            return -1;
+        }
+    }
+    else {
+        frame_buffer = new GLubyte*[MAX_FRAMES];
+    }
+    for (int i = 0; i < MAX_FRAMES; i++)
+        frame_sources[i] = i;
+
+    // INIT PREVIEW SERVER
+    PreviewServer preview_server;
+    GLubyte* preview_pixels = nullptr;
+    if (USE_PREVIEW_SERVER) {
+        if (start_preview_server(preview_server, PREVIEW_PORT, FRAME_WIDTH, FRAME_HEIGHT, false))
+            cout << "PREVIEW: http://" << PREVIEW_BIND_ADDRESS << ":" << PREVIEW_PORT << "/" << endl;
+        else
+            cout << "FAILED TO START PREVIEW SERVER ON PORT " << PREVIEW_PORT << endl;
+        if (!SAVE_FRAMES)
+            preview_pixels = new GLubyte[PIXEL_BUFFER_SIZE];
+    }
 
     chrono::system_clock::time_point start_time = chrono::system_clock::now();
 
@@ -296,19 +1300,164 @@ int main(void)
 
         // GET TIME
         float timeValue = (float)frame / (float)MAX_FRAMES * 3.141f * 2.0f / 0.132f;
-        glUniform1f(timeLocation, timeValue);
+
+        if (USE_FRAME_CACHE && SAVE_FRAMES) {
+            // SKIP THE RENDER WHEN AN EARLIER FRAME HAD THE SAME SHADER PARAMETERS
+            int source = lookup_frame_cache(frame_cache, frame_cache_key(compute_frame_parameters(timeValue)), frame);
+            if (source != frame) {
+                frame_sources[frame] = source;
+                if (USE_FRAME_CONTAINER) {
+                    container.index[frame].offset = container.index[source].offset;
+                    container.index[frame].time = timeValue;
+                    container.index[frame].written = 1;
+                }
+                else {
+                    frame_buffer[frame] = nullptr;
+                }
+                cached_frames++;
+
+                cout << "CACHED: " << frame + 1 << "/" << MAX_FRAMES << " (SAME AS FRAME " << source << ")" << endl;
+
+                glfwPollEvents();
+                frame++;
+                continue;
+            }
+        }
+
+        // CULL PIXELS OUTSIDE THE PROJECTED BOUNDING SPHERE
+        if (USE_BOUND_CULLING) {
+            pipeline.scissor = project_bounding_sphere(compute_frame_parameters(timeValue));
+            pipeline.use_scissor = true;
+        }
+
+        if (REPORT_CULLING) {
+            // TIME THE FULL SCREEN MARCH AGAINST THE CULLED ONE
+            int samples = USE_DENOISE ? DENOISE_SAMPLES : 0;
+            ScreenRect rect = project_bounding_sphere(compute_frame_parameters(timeValue));
+
+            glFinish();
+            chrono::steady_clock::time_point unculled_start = chrono::steady_clock::now();
+            pipeline.use_scissor = false;
+            set_unbounded(pipeline, true);
+            render_frame(pipeline, timeValue, samples, USE_DENOISE);
+            glFinish();
+            chrono::duration<double> unculled_time = chrono::steady_clock::now() - unculled_start;
+
+            chrono::steady_clock::time_point culled_start = chrono::steady_clock::now();
+            pipeline.scissor = rect;
+            pipeline.use_scissor = true;
+            set_unbounded(pipeline, false);
+            render_frame(pipeline, timeValue, samples, USE_DENOISE);
+            glFinish();
+            chrono::duration<double> culled_time = chrono::steady_clock::now() - culled_start;
+
+            pipeline.use_scissor = USE_BOUND_CULLING;
+
+            double culled = 1.0 - (double)rect.width * rect.height / ((double)FRAME_WIDTH * FRAME_HEIGHT);
+            culled_sum += culled;
+            unculled_time_sum += unculled_time.count();
+            culled_time_sum += culled_time.count();
+
+            cout << "CULLED: " << culled * 100.0 << "% OF PIXELS | " << unculled_time.count() * 1000.0 << "ms -> " << culled_time.count() * 1000.0 << "ms"
+                 << " (" << unculled_time.count() / culled_time.count() << "x)" << endl;
+        }
+
+        if (COMPARE_TO_REFERENCE) {
+            // RENDER REFERENCE FRAME
+            render_frame(pipeline, timeValue, REFERENCE_SAMPLES, false);
+            glPixelStorei(GL_PACK_ALIGNMENT, 1);
+            glReadPixels(0, 0, FRAME_WIDTH, FRAME_HEIGHT, GL_RGB, GL_UNSIGNED_BYTE, reference_pixels);
+        }
+
+        if (COMPARE_RELAXATION) {
+            // MARCH PLAIN, THEN OVER-RELAXED, WITHOUT DENOISING
+            int samples = USE_DENOISE ? DENOISE_SAMPLES : 0;
+            glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+            set_relaxation(pipeline, 1.0f);
+            HeatmapStats plain = render_heatmap(pipeline, timeValue, samples, false, heatmap_values);
+            render_frame(pipeline, timeValue, samples, false);
+            glReadPixels(0, 0, FRAME_WIDTH, FRAME_HEIGHT, GL_RGB, GL_UNSIGNED_BYTE, plain_pixels);
+
+            set_relaxation(pipeline, COMPARE_RELAXATION_FACTOR);
+            HeatmapStats relaxed = render_heatmap(pipeline, timeValue, samples, false, heatmap_values);
+            render_frame(pipeline, timeValue, samples, false);
+            glReadPixels(0, 0, FRAME_WIDTH, FRAME_HEIGHT, GL_RGB, GL_UNSIGNED_BYTE, relaxed_pixels);
+
+            set_relaxation(pipeline, 0.0f);
+
+            float psnr = compute_psnr(plain_pixels, relaxed_pixels);
+            float ssim = compute_ssim(plain_pixels, relaxed_pixels);
+            plain_sum.mean_steps += plain.mean_steps;
+            relaxed_sum.mean_steps += relaxed.mean_steps;
+            relaxation_psnr_sum += psnr;
+            relaxation_ssim_sum += ssim;
+
+            cout << "RELAXATION STEPS: " << plain.mean_steps << " -> " << relaxed.mean_steps << " (MAX " << plain.max_steps << " -> " << relaxed.max_steps << ")"
+                 << " | PSNR: " << psnr << "dB SSIM: " << ssim << endl;
+        }
 
         // RENDER FRACTAL
-        glClear(GL_COLOR_BUFFER_BIT);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+        render_frame(pipeline, timeValue, USE_DENOISE ? DENOISE_SAMPLES : 0, USE_DENOISE);
+
+        if (COMPARE_TO_REFERENCE) {
+            // COMPARE AGAINST REFERENCE FRAME
+            glPixelStorei(GL_PACK_ALIGNMENT, 1);
+            glReadPixels(0, 0, FRAME_WIDTH, FRAME_HEIGHT, GL_RGB, GL_UNSIGNED_BYTE, compare_pixels);
+            float psnr = compute_psnr(reference_pixels, compare_pixels);
+            float ssim = compute_ssim(reference_pixels, compare_pixels);
+            psnr_sum += psnr;
+            ssim_sum += ssim;
+            cout << "PSNR: " << psnr << "dB SSIM: " << ssim << endl;
+        }
 
-        if (SAVE_FRAMES) {
+        if (SAVE_STEP_HEATMAP) {
+            // MEASURE EXACT MARCHER, THEN SAVE THE LOD HEATMAP
+            int samples = USE_DENOISE ? DENOISE_SAMPLES : 0;
+            HeatmapStats exact = render_heatmap(pipeline, timeValue, samples, true, heatmap_values);
+            set_lod(pipeline, true);
+            HeatmapStats lod = render_heatmap(pipeline, timeValue, samples, false, heatmap_values);
+            set_lod(pipeline, false);
+            save_frame("./output/heatmap_" + to_string(frame) + ".bmp", heatmap_pixels(heatmap_values));
+
+            exact_sum.mean_steps += exact.mean_steps;
+            exact_sum.mean_escape_iters += exact.mean_escape_iters;
+            lod_sum.mean_steps += lod.mean_steps;
+            lod_sum.mean_escape_iters += lod.mean_escape_iters;
+
+            cout << "STEPS: " << exact.mean_steps << " -> " << lod.mean_steps << " (MAX " << exact.max_steps << " -> " << lod.max_steps << ")"
+                 << " | ESCAPE ITERS: " << exact.mean_escape_iters << " -> " << lod.mean_escape_iters << endl;
+        }
+
+        if (SAVE_FRAMES && USE_FRAME_CONTAINER) {
+            // READ PIXELS STRAIGHT INTO THE MAPPED SLOT, THE KERNEL WRITES IT BACK
+            glPixelStorei(GL_PACK_ALIGNMENT, 4);
+            glReadPixels(0, 0, FRAME_WIDTH, FRAME_HEIGHT, GL_BGR, GL_UNSIGNED_BYTE, frame_slot(container, frame));
+            container.index[frame].time = timeValue;
+            container.index[frame].written = 1;
+        }
+        else if (SAVE_FRAMES) {
             // ADD PIXELS TO FRAME BUFFEER
             GLubyte* pixels = new GLubyte[PIXEL_BUFFER_SIZE];
             glReadPixels(0, 0, FRAME_WIDTH, FRAME_HEIGHT, GL_RGB, GL_UNSIGNED_BYTE, pixels);
             frame_buffer[frame] = pixels;
         }
 
+        if (USE_PREVIEW_SERVER) {
+            // HAND THE READBACK TO THE PREVIEW ENCODER
+            if (SAVE_FRAMES && USE_FRAME_CONTAINER) {
+                submit_preview_frame(preview_server, frame_slot(container, frame), BITMAP_ROW_SIZE, true);
+            }
+            else if (SAVE_FRAMES) {
+                submit_preview_frame(preview_server, frame_buffer[frame], FRAME_WIDTH * 3, false);
+            }
+            else {
+                glPixelStorei(GL_PACK_ALIGNMENT, 1);
+                glReadPixels(0, 0, FRAME_WIDTH, FRAME_HEIGHT, GL_RGB, GL_UNSIGNED_BYTE, preview_pixels);
+                submit_preview_frame(preview_server, preview_pixels, FRAME_WIDTH * 3, false);
+            }
+        }
+
         // SWAP FRONT AND BACK BUFFERS
         glfwSwapBuffers(window);
 
@@ -321,18 +1470,53 @@ int main(void)
             chrono::duration<float> duration_frame = end_frame - start_frame;
         
             cout << "RENDERED: " << frame + 1 << "/" << MAX_FRAMES << " (" << floor((float)(frame + 1.0f) / (float)MAX_FRAMES * 1000.0f) / 10.0f << "%)" << " " << sec_to_time(duration_frame.count()) << " | ETA: " << sec_to_time((float)(MAX_FRAMES - (frame + 1)) * duration_frame.count()) << endl;
+
+            if (USE_DENOISE)
+                cout << pass_timings(pipeline) << endl;
         }
         frame++;
     }
-    if (SAVE_FRAMES) {
+    int rendered_frames = frame - cached_frames;
+    if (USE_FRAME_CACHE && frame > 0) {
+        cout << "FRAME CACHE: " << rendered_frames << " UNIQUE FRAME(S) RENDERED, " << cached_frames << " REPEAT(S) REUSED"
+             << " (" << floor((float)cached_frames / (float)frame * 1000.0f) / 10.0f << "% OF RENDERS SAVED)" << endl;
+    }
+    if (SAVE_STEP_HEATMAP && rendered_frames > 0) {
+        cout << "MEAN STEPS PER PIXEL: " << exact_sum.mean_steps / rendered_frames << " -> " << lod_sum.mean_steps / rendered_frames
+             << " | MEAN ESCAPE ITERS PER RAY: " << exact_sum.mean_escape_iters / rendered_frames << " -> " << lod_sum.mean_escape_iters / rendered_frames << " (EXACT -> LOD)" << endl;
+    }
+    if (REPORT_CULLING && rendered_frames > 0) {
+        cout << "MEAN CULLED: " << culled_sum / rendered_frames * 100.0 << "% OF PIXELS | " << unculled_time_sum / rendered_frames * 1000.0 << "ms -> " << culled_time_sum / rendered_frames * 1000.0 << "ms"
+             << " (" << unculled_time_sum / culled_time_sum << "x)" << endl;
+    }
+    if (COMPARE_RELAXATION && rendered_frames > 0) {
+        cout << "MEAN STEPS PER PIXEL: " << plain_sum.mean_steps / rendered_frames << " -> " << relaxed_sum.mean_steps / rendered_frames
+             << " | MEAN PSNR: " << relaxation_psnr_sum / rendered_frames << "dB MEAN SSIM: " << relaxation_ssim_sum / rendered_frames << " (PLAIN -> RELAXATION " << COMPARE_RELAXATION_FACTOR << ")" << endl;
+    }
+    if (COMPARE_TO_REFERENCE && rendered_frames > 0) {
+        cout << "MEAN PSNR: " << psnr_sum / rendered_frames << "dB MEAN SSIM: " << ssim_sum / rendered_frames << " (" << (USE_DENOISE ? DENOISE_SAMPLES : REFERENCE_SAMPLES) << " vs " << REFERENCE_SAMPLES << " samples)" << endl;
+    }
+    if (SAVE_FRAMES && USE_FRAME_CONTAINER) {
+        // UNMAP CONTAINER, FRAMES ARE EXTRACTED ON DEMAND WITH "extract"
+        close_frame_container(container);
+
+        chrono::time_point<chrono::system_clock> end_time = chrono::system_clock::now();
+        chrono::duration<float> duration = end_time - start_time;
+        cout << "SAVED " << frame << " FRAME(S) TO " << FRAME_CONTAINER_PATH << endl;
+        cout << "Total time taken: " << sec_to_time(duration.count()) << endl;
+    }
+    else if (SAVE_FRAMES) {
         cout << "SAVING FRAMES..." << endl;
 
         // SAVE ALL FRAMES TO DISK
-        for (int i = start_frame; i < frame + 1; i++) {
+        for (int i = start_frame; i < frame; i++) {
             chrono::system_clock::time_point start_frame = chrono::system_clock::now();
         
-            // SAVE FRAME TO DISK
-            save_frame("./output/frame_" + to_string(i) + ".bmp", frame_buffer[i]);
+            // SAVE FRAME TO DISK, CACHED REPEATS LINK TO THEIR FIRST RENDER
+            if (frame_sources[i] != i)
+                link_frame("./output/frame_" + to_string(frame_sources[i]) + ".bmp", "./output/frame_" + to_string(i) + ".bmp");
+            else
+                save_frame("./output/frame_" + to_string(i) + ".bmp", frame_buffer[i]);
 
             // UPDATE PROGRESS
             chrono::time_point<chrono::system_clock> end_frame = chrono::system_clock::now();
@@ -345,11 +1529,40 @@ int main(void)
         chrono::duration<float> duration = end_time - start_time;
         cout << "Total time taken: " << sec_to_time(duration.count()) << endl;
     }
+    // STOP PREVIEW SERVER
+    stop_preview_server(preview_server);
+    delete[] preview_pixels;
+
     // DELTE SHADER
     glDeleteProgram(shader);
 
+    if (USE_DENOISE) {
+        // DELETE DENOISER
+        glDeleteProgram(pipeline.denoise_shader);
+        glDeleteQueries(DENOISE_PASSES + 1, pipeline.timer_queries);
+        glDeleteFramebuffers(1, &pipeline.scene_fbo);
+        glDeleteFramebuffers(2, pipeline.pass_fbo);
+        glDeleteTextures(1, &pipeline.scene_color);
+        glDeleteTextures(1, &pipeline.scene_guide);
+        glDeleteTextures(2, pipeline.pass_color);
+    }
+
+    if (SAVE_STEP_HEATMAP || COMPARE_RELAXATION) {
+        // DELETE HEATMAP
+        glDeleteFramebuffers(1, &pipeline.heatmap_fbo);
+        glDeleteTextures(1, &pipeline.heatmap_texture);
+        delete[] heatmap_values;
+    }
+
+    // CLEAR COMPARISON BUFFERS
+    delete[] reference_pixels;
+    delete[] compare_pixels;
+    delete[] plain_pixels;
+    delete[] relaxed_pixels;
+
     // CLEAR FRAMES BUFFER
     delete[] frame_buffer;
+    delete[] frame_sources;
 
     // TERMINATE THE LIBRARY
     glfwTerminate();
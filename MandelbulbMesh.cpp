@@ -0,0 +1,457 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <sstream>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include <thread>
+#include <algorithm>
+
+using namespace std;
+
+struct vec3 {
+    float x;
+    float y;
+    float z;
+};
+
+float length(const vec3& a) {
+    return sqrt(a.x * a.x + a.y * a.y + a.z * a.z);
+}
+
+// GRID SETTINGS (OVERRIDABLE FROM THE COMMAND LINE)
+float POWER = 8.0f;
+int GRID_RESOLUTION = 512;
+string OUTPUT_PATH = "./output/mandelbulb.ply";
+
+// SAMPLED CUBE [-BOUND_RADIUS, BOUND_RADIUS]^3: EVERY POINT OUTSIDE THE ESCAPE
+// RADIUS ESCAPES AT ONCE, SO THE CUBE FACES ARE OUTSIDE AND THE MESH IS CLOSED
+const float BOUND_RADIUS = 2.0f;
+
+// ESCAPE ITERATIONS, DETAIL FINER THAN A VOXEL NEEDS NO MORE
+const int MAX_ITERS = 100;
+
+// ISO SURFACE AT A FRACTION OF A VOXEL SO THIN FILAMENTS SURVIVE SAMPLING
+const float ISO_VOXEL_SCALE = 0.5f;
+
+// TILES OF TILE_SIZE x TILE_SIZE SAMPLES ARE SKIPPED WHEN FAR FROM THE SURFACE
+const int TILE_SIZE = 16;
+const float DE_SAFETY = 0.8f;
+
+// PALETTE (SAME AS res/shaders/Basic.frag)
+const float COLOR_OFFSET = 2.520f;
+const vec3 COLOR_A = { 0.500f, 0.500f, 0.500f };
+const vec3 COLOR_B = { 0.500f, 0.500f, 0.500f };
+const vec3 COLOR_C = { 1.000f, 1.000f, 1.000f };
+const vec3 COLOR_D = { 0.000f, 0.948f, 0.888f };
+
+// SMOOTH ESCAPE ITERATION TO PALETTE PHASE: SURFACE VERTICES ESCAPE AFTER ~2.5-4
+// ITERATIONS, SO ONE ITERATION COVERS ABOUT A THIRD OF THE SINE
+const float ESCAPE_COLOR_SCALE = 2.0f;
+
+struct MeshVertex {
+    float x;
+    float y;
+    float z;
+    float escape;
+    unsigned char r;
+    unsigned char g;
+    unsigned char b;
+};
+
+struct MeshFace {
+    int a;
+    int b;
+    int c;
+};
+
+// COLOR PALETTE
+vec3 palette(float t) {
+    return {
+        COLOR_A.x + COLOR_B.x * cos(6.28318f * (COLOR_C.x * t + COLOR_D.x)),
+        COLOR_A.y + COLOR_B.y * cos(6.28318f * (COLOR_C.y * t + COLOR_D.y)),
+        COLOR_A.z + COLOR_B.z * cos(6.28318f * (COLOR_C.z * t + COLOR_D.z))
+    };
+}
+
+// MANDEL BULB SIGNED DISTANCE FUNCTION (CPU PORT OF THE SHADER VERSION)
+// escape IS THE SMOOTH ESCAPE ITERATION, MAX_ITERS INSIDE THE SET
+float mandelbulb_distance(const vec3& point, float power, float& escape) {
+    vec3 z = point;
+    float dr = 1.0f;
+    float r = 0.0f;
+    escape = (float)MAX_ITERS;
+    for (int i = 0; i < MAX_ITERS; i++) {
+        r = length(z);
+        if (r > BOUND_RADIUS) {
+            escape = (float)i + 1.0f - log(log(r)) / log(max(power, 1.01f));
+            break;
+        }
+        float theta = atan2(z.y, z.x);
+        float phi = acos(z.z / r);
+        dr = pow(r, power - 1.0f) * power * dr + 1.0f;
+        float zr = pow(r, power);
+        theta = theta * power;
+        phi = phi * power;
+        z = {
+            sin(phi) * cos(theta) * zr + point.x,
+            sin(phi) * sin(theta) * zr + point.y,
+            cos(phi) * zr + point.z
+        };
+    }
+    return 0.5f * log(r) * r / dr;
+}
+float mandelbulb_distance(const vec3& point, float power) {
+    float escape;
+    return mandelbulb_distance(point, power, escape);
+}
+
+// RUN body(row_begin, row_end, thread_index) OVER ROWS ON ALL CORES
+template <typename Body>
+void parallel_rows(int rows, int thread_count, const Body& body)
+{
+    vector<thread> threads;
+    int rows_per_thread = (rows + thread_count - 1) / thread_count;
+    for (int t = 0; t < thread_count; t++) {
+        int begin = t * rows_per_thread;
+        int end = min(rows, begin + rows_per_thread);
+        if (begin >= end)
+            break;
+        threads.emplace_back([&body, begin, end, t]() { body(begin, end, t); });
+    }
+    for (thread& worker : threads)
+        worker.join();
+}
+
+// STREAMING SURFACE NETS EXTRACTOR
+// The grid is walked one z-plane at a time: only two sample planes and two
+// planes of cell vertex indices are alive, so memory is O(resolution^2).
+// Vertices and faces are streamed to temporary files and joined into a
+// binary PLY once the counts are known.
+struct MeshExtractor {
+    int n;
+    float power;
+    float voxel;
+    float iso;
+    int thread_count;
+
+    vector<float> sample_planes[2];
+    vector<int> cell_planes[2];
+
+    ofstream vertex_file;
+    ofstream face_file;
+    int vertex_count = 0;
+    long long face_count = 0;
+
+    long long sampled = 0;
+    long long skipped = 0;
+
+    vec3 grid_point(float x, float y, float z) const {
+        return { -BOUND_RADIUS + x * voxel, -BOUND_RADIUS + y * voxel, -BOUND_RADIUS + z * voxel };
+    }
+
+    // SAMPLE ONE PLANE, SKIPPING TILES THE DISTANCE ESTIMATE PROVES EMPTY
+    void sample_plane(int z, vector<float>& plane) {
+        int tiles = (n + TILE_SIZE - 1) / TILE_SIZE;
+        vector<long long> thread_sampled(thread_count, 0);
+        vector<long long> thread_skipped(thread_count, 0);
+
+        parallel_rows(tiles, thread_count, [&](int begin, int end, int t) {
+            for (int ty = begin; ty < end; ty++) {
+                for (int tx = 0; tx < tiles; tx++) {
+                    int x0 = tx * TILE_SIZE;
+                    int y0 = ty * TILE_SIZE;
+                    int x1 = min(n, x0 + TILE_SIZE);
+                    int y1 = min(n, y0 + TILE_SIZE);
+
+                    // Every sample of the tile is within half_diagonal of its center
+                    float half_w = (x1 - 1 - x0) * 0.5f * voxel;
+                    float half_h = (y1 - 1 - y0) * 0.5f * voxel;
+                    float half_diagonal = sqrt(half_w * half_w + half_h * half_h);
+                    float center_dist = mandelbulb_distance(grid_point((x0 + x1 - 1) * 0.5f, (y0 + y1 - 1) * 0.5f, (float)z), power);
+                    float bound = center_dist * DE_SAFETY - half_diagonal - iso;
+
+                    if (bound > 0.0f) {
+                        for (int y = y0; y < y1; y++)
+                            for (int x = x0; x < x1; x++)
+                                plane[y * n + x] = bound;
+                        thread_skipped[t] += (x1 - x0) * (y1 - y0);
+                        continue;
+                    }
+
+                    for (int y = y0; y < y1; y++)
+                        for (int x = x0; x < x1; x++)
+                            plane[y * n + x] = mandelbulb_distance(grid_point((float)x, (float)y, (float)z), power) - iso;
+                    thread_sampled[t] += (x1 - x0) * (y1 - y0);
+                }
+            }
+        });
+
+        for (int t = 0; t < thread_count; t++) {
+            sampled += thread_sampled[t];
+            skipped += thread_skipped[t];
+        }
+    }
+
+    // PLACE ONE VERTEX IN EVERY CELL OF THE SLAB THE SURFACE CROSSES
+    void extract_cells(int z, const vector<float>& lower, const vector<float>& upper, vector<int>& cells) {
+        vector<vector<MeshVertex>> thread_vertices(thread_count);
+        vector<vector<int>> thread_cells(thread_count);
+
+        parallel_rows(n - 1, thread_count, [&](int begin, int end, int t) {
+            for (int y = begin; y < end; y++) {
+                for (int x = 0; x < n - 1; x++) {
+                    float corner[8];
+                    int mask = 0;
+                    for (int c = 0; c < 8; c++) {
+                        int cx = x + (c & 1);
+                        int cy = y + ((c >> 1) & 1);
+                        const vector<float>& plane = (c & 4) ? upper : lower;
+                        corner[c] = plane[cy * n + cx];
+                        if (corner[c] < 0.0f)
+                            mask |= 1 << c;
+                    }
+
+                    cells[y * n + x] = -1;
+                    if (mask == 0 || mask == 255)
+                        continue;
+
+                    // Average the crossings of the 12 cell edges
+                    float sx = 0.0f, sy = 0.0f, sz = 0.0f;
+                    int crossings = 0;
+                    for (int a = 0; a < 8; a++) {
+                        for (int axis = 0; axis < 3; axis++) {
+                            int b = a | (1 << axis);
+                            if (b == a)
+                                continue;
+                            if (((mask >> a) & 1) == ((mask >> b) & 1))
+                                continue;
+                            float f = corner[a] / (corner[a] - corner[b]);
+                            sx += (a & 1) + (axis == 0 ? f : 0.0f);
+                            sy += ((a >> 1) & 1) + (axis == 1 ? f : 0.0f);
+                            sz += ((a >> 2) & 1) + (axis == 2 ? f : 0.0f);
+                            crossings++;
+                        }
+                    }
+
+                    vec3 position = grid_point(x + sx / crossings, y + sy / crossings, z + sz / crossings);
+
+                    // The shader indexes the palette by march steps, which a mesh has
+                    // none of; the smooth escape iteration at the vertex replaces them
+                    float escape;
+                    mandelbulb_distance(position, power, escape);
+                    float s = (1.0f + sin(escape * ESCAPE_COLOR_SCALE + COLOR_OFFSET)) / 2.0f * 2.296f + 2.216f;
+                    vec3 color = palette(s);
+
+                    thread_vertices[t].push_back({
+                        position.x, position.y, position.z, escape,
+                        (unsigned char)(min(max(color.x, 0.0f), 1.0f) * 255.0f),
+                        (unsigned char)(min(max(color.y, 0.0f), 1.0f) * 255.0f),
+                        (unsigned char)(min(max(color.z, 0.0f), 1.0f) * 255.0f)
+                    });
+                    thread_cells[t].push_back(y * n + x);
+                }
+            }
+        });
+
+        // Number vertices in row order so output is deterministic
+        for (int t = 0; t < thread_count; t++) {
+            for (size_t i = 0; i < thread_vertices[t].size(); i++) {
+                cells[thread_cells[t][i]] = vertex_count++;
+                write_vertex(thread_vertices[t][i]);
+            }
+        }
+    }
+
+    // CONNECT THE FOUR CELLS AROUND EVERY GRID EDGE WITH A SIGN CHANGE
+    void extract_faces(int z, const vector<float>& lower, const vector<float>& upper, const vector<int>& previous_cells, const vector<int>& cells) {
+        vector<vector<MeshFace>> thread_faces(thread_count);
+
+        parallel_rows(n, thread_count, [&](int begin, int end, int t) {
+            vector<MeshFace>& faces = thread_faces[t];
+            auto quad = [&faces](int a, int b, int c, int d, bool flip) {
+                if (a < 0 || b < 0 || c < 0 || d < 0)
+                    return;
+                if (flip) {
+                    faces.push_back({ a, d, c });
+                    faces.push_back({ a, c, b });
+                }
+                else {
+                    faces.push_back({ a, b, c });
+                    faces.push_back({ a, c, d });
+                }
+            };
+
+            for (int y = begin; y < end; y++) {
+                for (int x = 0; x < n; x++) {
+                    float v = lower[y * n + x];
+                    bool inside = v < 0.0f;
+
+                    // Edge along x in sample plane z, shared with the previous slab
+                    if (z > 0 && y > 0 && x < n - 1 && inside != (lower[y * n + x + 1] < 0.0f))
+                        quad(cells[y * n + x], previous_cells[y * n + x], previous_cells[(y - 1) * n + x], cells[(y - 1) * n + x], inside);
+
+                    // Edge along y in sample plane z, shared with the previous slab
+                    if (z > 0 && x > 0 && y < n - 1 && inside != (lower[(y + 1) * n + x] < 0.0f))
+                        quad(cells[y * n + x], cells[y * n + x - 1], previous_cells[y * n + x - 1], previous_cells[y * n + x], inside);
+
+                    // Edge along z between planes z and z + 1
+                    if (x > 0 && y > 0 && inside != (upper[y * n + x] < 0.0f))
+                        quad(cells[y * n + x], cells[(y - 1) * n + x], cells[(y - 1) * n + x - 1], cells[y * n + x - 1], inside);
+                }
+            }
+        });
+
+        for (int t = 0; t < thread_count; t++)
+            for (const MeshFace& face : thread_faces[t])
+                write_face(face);
+    }
+
+    void write_vertex(const MeshVertex& vertex) {
+        vertex_file.write(reinterpret_cast<const char*>(&vertex.x), sizeof(float) * 4);
+        vertex_file.write(reinterpret_cast<const char*>(&vertex.r), 3);
+    }
+
+    void write_face(const MeshFace& face) {
+        unsigned char corners = 3;
+        face_file.write(reinterpret_cast<const char*>(&corners), 1);
+        face_file.write(reinterpret_cast<const char*>(&face), sizeof(int) * 3);
+        face_count++;
+    }
+};
+
+// JOIN THE STREAMED VERTEX / FACE FILES INTO A BINARY PLY
+bool write_ply(const string& filename, const string& vertex_path, const string& face_path, int vertex_count, long long face_count)
+{
+    ofstream file(filename, ios::binary);
+    if (!file)
+        return false;
+
+    file << "ply\n";
+    file << "format binary_little_endian 1.0\n";
+    file << "comment Mandelbulb power " << POWER << "\n";
+    file << "element vertex " << vertex_count << "\n";
+    file << "property float x\n";
+    file << "property float y\n";
+    file << "property float z\n";
+    file << "property float escape\n";
+    file << "property uchar red\n";
+    file << "property uchar green\n";
+    file << "property uchar blue\n";
+    file << "element face " << face_count << "\n";
+    file << "property list uchar int vertex_indices\n";
+    file << "end_header\n";
+
+    ifstream vertices(vertex_path, ios::binary);
+    ifstream faces(face_path, ios::binary);
+    // Copying an empty stream sets failbit, so only copy what was written
+    if (vertex_count > 0)
+        file << vertices.rdbuf();
+    if (face_count > 0)
+        file << faces.rdbuf();
+
+    return (bool)file;
+}
+
+string sec_to_time(float time)
+{
+    float n_time = time;
+    string suffix = " second(s)";
+    if (n_time > 60.0f * 60.0f * 24.0f)
+    {
+        n_time /= 60.0f * 60.0f * 24.0f;
+        suffix = " day(s)";
+    }
+    else if (n_time > 60.0f * 60.0f)
+    {
+        n_time /= 60.0f * 60.0f;
+        suffix = " hour(s)";
+    }
+    else if (n_time > 60.0f)
+    {
+        n_time /= 60.0f;
+        suffix = " minute(s)";
+    }
+
+
+    return to_string(n_time) + suffix;
+}
+
+// USAGE: MandelbulbMesh [power] [resolution] [output.ply]
+int main(int argc, char** argv)
+{
+    if (argc > 1)
+        POWER = (float)atof(argv[1]);
+    if (argc > 2)
+        GRID_RESOLUTION = max(atoi(argv[2]), 2);
+    if (argc > 3)
+        OUTPUT_PATH = argv[3];
+
+    chrono::system_clock::time_point start_time = chrono::system_clock::now();
+
+    // INIT EXTRACTOR
+    MeshExtractor extractor;
+    extractor.n = GRID_RESOLUTION;
+    extractor.power = POWER;
+    extractor.voxel = 2.0f * BOUND_RADIUS / (float)(GRID_RESOLUTION - 1);
+    extractor.iso = extractor.voxel * ISO_VOXEL_SCALE;
+    extractor.thread_count = max((int)thread::hardware_concurrency(), 1);
+
+    int plane_size = GRID_RESOLUTION * GRID_RESOLUTION;
+    for (int i = 0; i < 2; i++) {
+        extractor.sample_planes[i].resize(plane_size);
+        extractor.cell_planes[i].assign(plane_size, -1);
+    }
+
+    string vertex_path = OUTPUT_PATH + ".vertices.tmp";
+    string face_path = OUTPUT_PATH + ".faces.tmp";
+    extractor.vertex_file.open(vertex_path, ios::binary);
+    extractor.face_file.open(face_path, ios::binary);
+    if (!extractor.vertex_file || !extractor.face_file) {
+        cout << "FAILED TO OPEN " << OUTPUT_PATH << endl;
+        return -1;
+    }
+
+    cout << "EXTRACTING MESH: POWER " << POWER << ", " << GRID_RESOLUTION << "^3 GRID, " << extractor.thread_count << " THREAD(S)" << endl;
+
+    // WALK THE GRID ONE SLAB AT A TIME
+    extractor.sample_plane(0, extractor.sample_planes[0]);
+    for (int z = 0; z < GRID_RESOLUTION - 1; z++) {
+        vector<float>& lower = extractor.sample_planes[z & 1];
+        vector<float>& upper = extractor.sample_planes[(z + 1) & 1];
+        vector<int>& previous_cells = extractor.cell_planes[(z + 1) & 1];
+        vector<int>& cells = extractor.cell_planes[z & 1];
+
+        extractor.sample_plane(z + 1, upper);
+        extractor.extract_cells(z, lower, upper, cells);
+        extractor.extract_faces(z, lower, upper, previous_cells, cells);
+
+        if ((z + 1) % 64 == 0 || z == GRID_RESOLUTION - 2)
+            cout << "SLAB: " << z + 1 << "/" << GRID_RESOLUTION - 1 << " VERTICES: " << extractor.vertex_count << " FACES: " << extractor.face_count << endl;
+    }
+
+    extractor.vertex_file.close();
+    extractor.face_file.close();
+
+    // WRITE PLY
+    bool written = write_ply(OUTPUT_PATH, vertex_path, face_path, extractor.vertex_count, extractor.face_count);
+    remove(vertex_path.c_str());
+    remove(face_path.c_str());
+
+    if (!written) {
+        cout << "FAILED TO WRITE " << OUTPUT_PATH << endl;
+        return -1;
+    }
+
+    long long total = extractor.sampled + extractor.skipped;
+    chrono::time_point<chrono::system_clock> end_time = chrono::system_clock::now();
+    chrono::duration<float> duration = end_time - start_time;
+
+    cout << "SAVED: " << OUTPUT_PATH << " (" << extractor.vertex_count << " vertices, " << extractor.face_count << " faces)" << endl;
+    cout << "SAMPLES SKIPPED: " << floor((float)extractor.skipped / (float)total * 1000.0f) / 10.0f << "%" << endl;
+    cout << "Total time taken: " << sec_to_time(duration.count()) << endl;
+    return 0;
+}
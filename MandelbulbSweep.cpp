@@ -0,0 +1,374 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <sstream>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+
+#include "ParameterSweep.h"
+
+using namespace std;
+
+struct vec3 {
+    float x;
+    float y;
+    float z;
+};
+
+vec3 add(const vec3& a, const vec3& b) {
+    return { a.x + b.x, a.y + b.y, a.z + b.z };
+}
+vec3 sub(const vec3& a, const vec3& b) {
+    return { a.x - b.x, a.y - b.y, a.z - b.z };
+}
+vec3 scale(const vec3& a, float s) {
+    return { a.x * s, a.y * s, a.z * s };
+}
+float dot(const vec3& a, const vec3& b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+vec3 cross(const vec3& a, const vec3& b) {
+    vec3 result;
+    result.x = a.y * b.z - a.z * b.y;
+    result.y = a.z * b.x - a.x * b.z;
+    result.z = a.x * b.y - a.y * b.x;
+    return result;
+}
+float length(const vec3& a) {
+    return sqrt(a.x * a.x + a.y * a.y + a.z * a.z);
+}
+vec3 normalize(const vec3& a) {
+    float len = length(a);
+    return { a.x / len, a.y / len, a.z / len };
+}
+float fract(float x) {
+    return x - floor(x);
+}
+
+// SWEEP SETTINGS (OVERRIDABLE FROM THE COMMAND LINE)
+int TILE_SIZE = SWEEP_TILE_SIZE;
+int SAMPLES = SWEEP_SAMPLES;
+string OUTPUT_PATH = "./output/sweep_cpu.bmp";
+
+// MARCHER SETTINGS (SAME AS res/shaders/Basic.frag)
+const int MAX_ITERS = 500;
+const int MAX_ITERS_MARCH = 500;
+const float EPSILON = 0.0001f;
+const float BOUND_RADIUS = 2.0f;
+const bool USE_LOD = false;
+const float LOD_PIXEL_SCALE = 0.5f;
+const float LOD_ITERS_SCALE = 2.0f;
+const float LOD_ITERS_MARGIN = 8.0f;
+const float LOD_STEPS_SCALE = 16.0f;
+const float LOD_STEPS_MARGIN = 64.0f;
+const float FOV = 12.0f;
+const float FOCAL_LENGTH = 2.920f;
+const float APERTURE = 0.024f;
+
+// OVER-RELAXED SPHERE TRACING (SAME AS res/shaders/Basic.frag)
+const bool USE_OVER_RELAXATION = false;
+const float RELAXATION = 1.6f;
+
+// RENDER THE SHEET PLAIN AND RELAXED, REPORT MARCH STEPS AND PSNR BETWEEN THE TWO
+const bool COMPARE_RELAXATION = false;
+const float COMPARE_RELAXATION_FACTOR = 1.6f;
+
+// MARCH STEPS OVER ALL RAYS OF A RENDER
+struct MarchStats {
+    long long rays = 0;
+    long long steps = 0;
+    int max_steps = 0;
+};
+
+// COLOR PALETTE OF A TILE
+vec3 palette(const SweepParameters& params, float t) {
+    return {
+        params.color_a[0] + params.color_b[0] * cos(6.28318f * (params.color_c[0] * t + params.color_d[0])),
+        params.color_a[1] + params.color_b[1] * cos(6.28318f * (params.color_c[1] * t + params.color_d[1])),
+        params.color_a[2] + params.color_b[2] * cos(6.28318f * (params.color_c[2] * t + params.color_d[2]))
+    };
+}
+
+// ESCAPE ITERATIONS NEEDED TO RESOLVE THE SURFACE TO WITHIN eps
+int escape_budget(float eps, float power) {
+    float needed = LOD_ITERS_MARGIN + LOD_ITERS_SCALE * log(1.0f / eps) / log(power);
+    return min((int)needed, MAX_ITERS);
+}
+
+// MARCH STEPS NEEDED TO CLOSE IN ON THE SURFACE TO THE PIXEL FOOTPRINT
+int march_budget(float pixel_cone) {
+    if (pixel_cone <= 0.0f)
+        return MAX_ITERS_MARCH;
+    float needed = LOD_STEPS_MARGIN + LOD_STEPS_SCALE * log(1.0f / (pixel_cone * LOD_PIXEL_SCALE));
+    return min((int)needed, MAX_ITERS_MARCH);
+}
+
+// MANDEL BULB SIGNED DISTANCE FUNCTION (CPU PORT OF THE SHADER VERSION)
+float mandelbulb_distance(const vec3& point, float power, int max_iters) {
+    vec3 z = point;
+    float dr = 1.0f;
+    float r = 0.0f;
+    for (int i = 0; i < max_iters; i++) {
+        r = length(z);
+        if (r > 2.0f)
+            break;
+        float theta = atan2(z.y, z.x);
+        float phi = acos(z.z / r);
+        dr = pow(r, power - 1.0f) * power * dr + 1.0f;
+        float zr = pow(r, power);
+        theta = theta * power;
+        phi = phi * power;
+        z = {
+            sin(phi) * cos(theta) * zr + point.x,
+            sin(phi) * sin(theta) * zr + point.y,
+            cos(phi) * zr + point.z
+        };
+    }
+    return 0.5f * log(r) * r / dr;
+}
+
+// RAY MARCH FRACTAL TOWARDS DIRECTION (CPU PORT OF ray_march_fractal)
+// relaxation 1 IS THE PLAIN SPHERE TRACER, steps RETURNS THE DISTANCE EVALUATIONS
+vec3 ray_march_fractal(const SweepParameters& params, const vec3& origin, const vec3& direction, float pixel_cone, float relaxation, int& steps) {
+    float power = params.power;
+    float omega = relaxation;
+    float step_length = 0.0f;
+    float prev_dist = 0.0f;
+    steps = 0;
+
+    // START AT THE BOUNDING SPHERE, MISSES RETURN AT ONCE
+    float b = dot(origin, direction);
+    float c = dot(origin, origin) - BOUND_RADIUS * BOUND_RADIUS;
+    float h = b * b - c;
+    if (h < 0.0f || -b + sqrt(h) < 0.0f)
+        return { 0.0f, 0.0f, 0.0f };
+    float total_dist = max(-b - sqrt(h), 0.0f);
+    float exit_dist = -b + sqrt(h);
+    vec3 pos = add(origin, scale(direction, total_dist));
+
+    int max_steps = march_budget(pixel_cone);
+    for (int i = 0; i < max_steps; i++) {
+        float footprint = total_dist * pixel_cone * LOD_PIXEL_SCALE;
+        float eps = max(EPSILON, footprint);
+        int max_iters = footprint > EPSILON ? escape_budget(eps, power) : MAX_ITERS;
+        float dist = mandelbulb_distance(pos, power, max_iters);
+        steps = i + 1;
+
+        // OVERSHOT: GO BACK AND TAKE THE SAFE STEP, STAY CONSERVATIVE FOR THE REST OF THE RAY
+        if (omega > 1.0f && dist + prev_dist < step_length) {
+            total_dist += prev_dist - step_length;
+            step_length = prev_dist;
+            omega = 1.0f;
+            pos = add(origin, scale(direction, total_dist));
+            continue;
+        }
+
+        step_length = dist * omega;
+        prev_dist = dist;
+        total_dist += step_length;
+        pos = add(origin, scale(direction, total_dist));
+        if (dist < eps) {
+            float s = (1.0f + sin((float)i * params.color_scale + params.color_offset)) / 2.0f * 2.296f + 2.216f;
+            float ao = pow((0.9f - max((float)i / (float)MAX_ITERS_MARCH, 0.0f)), 3.800f) + 0.5f;
+            return scale(palette(params, s), ao);
+        }
+        if (total_dist > exit_dist)
+            break;
+    }
+    return { 0.0f, 0.0f, 0.0f };
+}
+
+// PER PIXEL 0-1 OFFSET (INTERLEAVED GRADIENT NOISE, SAME AS THE SHADER)
+float pixel_noise(float x, float y) {
+    return fract(52.9829189f * fract(x * 0.06711056f + y * 0.00583715f));
+}
+
+// ROTATE VECTOR BY ANGLE AROUND AXIS
+vec3 rotate_vector(const vec3& vector, const vec3& axis, float angle) {
+    vec3 normalized_axis = normalize(axis);
+    float cos_theta = cos(angle);
+    float sin_theta = sin(angle);
+    vec3 crossed = cross(vector, normalized_axis);
+    float dotted = dot(vector, normalized_axis);
+    return add(add(scale(vector, cos_theta), scale(crossed, sin_theta)), scale(normalized_axis, dotted * (1.0f - cos_theta)));
+}
+
+// RENDER ONE TILE INTO THE SHEET (ROWS FROM THE BOTTOM, LIKE THE GPU READBACK)
+void render_tile(const SweepParameters& params, int index, const SweepLayout& layout, float relaxation, vector<unsigned char>& pixels, MarchStats& stats)
+{
+    int column = index % layout.columns;
+    int row = layout.rows - 1 - index / layout.columns;
+    int x0 = column * layout.tile_width;
+    int y0 = row * layout.tile_height;
+
+    vec3 cam_pos = { params.camera_position[0], params.camera_position[1], params.camera_position[2] };
+    vec3 center = { params.target[0], params.target[1], params.target[2] };
+
+    // The shader rotates +z onto the view direction
+    vec3 z_axis = { 0.0f, 0.0f, 1.0f };
+    vec3 newdir = normalize(sub(center, cam_pos));
+    vec3 axis = cross(z_axis, newdir);
+    float theta = -acos(min(max(dot(z_axis, newdir), -1.0f), 1.0f));
+    bool rotate = length(axis) > 1e-6f;
+
+    float tan_half_fov = tan(FOV * (3.141f / 180.0f) * 0.5f);
+    float pixel_cone = USE_LOD ? 2.0f * tan_half_fov / (float)layout.tile_height : 0.0f;
+
+    for (int y = 0; y < layout.tile_height; y++) {
+        for (int x = 0; x < layout.tile_width; x++) {
+            float u = ((float)x + 0.5f) / (float)layout.tile_width * 2.0f - 1.0f;
+            float v = ((float)y + 0.5f) / (float)layout.tile_height * 2.0f - 1.0f;
+            vec3 direction = normalize({ tan_half_fov * u, tan_half_fov * v, 1.0f });
+            if (rotate)
+                direction = rotate_vector(direction, axis, theta);
+
+            // DOF SAMPLES ON THE SAME R2 PATTERN AS THE SHADER
+            float pixel_x = (float)(x0 + x) + 0.5f;
+            float pixel_y = (float)(y0 + y) + 0.5f;
+            float offset = pixel_noise(pixel_x, pixel_y);
+            vec3 focal_point = add(cam_pos, scale(direction, FOCAL_LENGTH));
+            vec3 color = { 0.0f, 0.0f, 0.0f };
+            for (int i = 0; i < SAMPLES; i++) {
+                float jitter_x = fract(0.7548776662f * (float)(i + 1) + offset) * 2.0f - 1.0f;
+                float jitter_y = fract(0.5698402910f * (float)(i + 1) + fract(offset * 1.618034f)) * 2.0f - 1.0f;
+                vec3 new_cam_pos = add(cam_pos, { jitter_x * APERTURE, jitter_y * APERTURE, 0.0f });
+                vec3 new_direction = normalize(sub(focal_point, new_cam_pos));
+                int steps;
+                color = add(color, ray_march_fractal(params, new_cam_pos, new_direction, pixel_cone, relaxation, steps));
+                stats.rays++;
+                stats.steps += steps;
+                stats.max_steps = max(stats.max_steps, steps);
+            }
+            color = scale(color, 1.0f / (float)SAMPLES);
+
+            size_t position = ((size_t)(y0 + y) * layout.width + (x0 + x)) * 3;
+            pixels[position + 0] = (unsigned char)(min(max(color.x, 0.0f), 1.0f) * 255.0f + 0.5f);
+            pixels[position + 1] = (unsigned char)(min(max(color.y, 0.0f), 1.0f) * 255.0f + 0.5f);
+            pixels[position + 2] = (unsigned char)(min(max(color.z, 0.0f), 1.0f) * 255.0f + 0.5f);
+        }
+    }
+}
+
+// RENDER EVERY TILE OF THE SHEET ON ALL CORES
+MarchStats render_sheet(const vector<SweepParameters>& grid, const SweepLayout& layout, float relaxation, vector<unsigned char>& pixels)
+{
+    int thread_count = max((int)thread::hardware_concurrency(), 1);
+
+    // TILES COST VERY DIFFERENT AMOUNTS, SO THREADS TAKE THE NEXT ONE WHEN DONE
+    atomic<int> next_tile(0);
+    int done_tiles = 0;
+    MarchStats stats;
+    mutex progress_mutex;
+    vector<thread> threads;
+    for (int t = 0; t < thread_count; t++) {
+        threads.emplace_back([&]() {
+            for (int index = next_tile++; index < (int)grid.size(); index = next_tile++) {
+                MarchStats tile_stats;
+                render_tile(grid[index], index, layout, relaxation, pixels, tile_stats);
+
+                lock_guard<mutex> lock(progress_mutex);
+                stats.rays += tile_stats.rays;
+                stats.steps += tile_stats.steps;
+                stats.max_steps = max(stats.max_steps, tile_stats.max_steps);
+                done_tiles++;
+                if (done_tiles % 8 == 0 || done_tiles == (int)grid.size())
+                    cout << "TILES: " << done_tiles << "/" << grid.size() << endl;
+            }
+        });
+    }
+    for (thread& worker : threads)
+        worker.join();
+    return stats;
+}
+
+// PEAK SIGNAL TO NOISE RATIO BETWEEN TWO RGB IMAGES IN dB
+float compute_psnr(const vector<unsigned char>& a, const vector<unsigned char>& b)
+{
+    double squared_error = 0.0;
+    for (size_t i = 0; i < a.size(); i++) {
+        double difference = (double)a[i] - (double)b[i];
+        squared_error += difference * difference;
+    }
+    double mse = squared_error / (double)a.size();
+    if (mse == 0.0)
+        return 100.0f;
+    return (float)(10.0 * log10(255.0 * 255.0 / mse));
+}
+
+string sec_to_time(float time)
+{
+    float n_time = time;
+    string suffix = " second(s)";
+    if (n_time > 60.0f * 60.0f * 24.0f)
+    {
+        n_time /= 60.0f * 60.0f * 24.0f;
+        suffix = " day(s)";
+    }
+    else if (n_time > 60.0f * 60.0f)
+    {
+        n_time /= 60.0f * 60.0f;
+        suffix = " hour(s)";
+    }
+    else if (n_time > 60.0f)
+    {
+        n_time /= 60.0f;
+        suffix = " minute(s)";
+    }
+
+
+    return to_string(n_time) + suffix;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 1)
+        TILE_SIZE = max(atoi(argv[1]), 1);
+    if (argc > 2)
+        SAMPLES = max(atoi(argv[2]), 1);
+    if (argc > 3)
+        OUTPUT_PATH = argv[3];
+
+    string index_path = sweep_index_path(OUTPUT_PATH);
+
+    vector<SweepParameters> grid = build_sweep_grid();
+    SweepLayout layout = sweep_layout((int)grid.size(), SWEEP_POWER_COUNT, TILE_SIZE);
+    vector<unsigned char> pixels((size_t)layout.width * layout.height * 3, 0);
+
+    int thread_count = max((int)thread::hardware_concurrency(), 1);
+    cout << "RENDERING SWEEP: " << grid.size() << " TILE(S) OF " << layout.tile_width << "x" << layout.tile_height << " (" << layout.width << "x" << layout.height << "), "
+         << SAMPLES << " SAMPLE(S), " << thread_count << " THREAD(S)" << endl;
+
+    chrono::system_clock::time_point start_time = chrono::system_clock::now();
+    float relaxation = COMPARE_RELAXATION ? 1.0f : (USE_OVER_RELAXATION ? RELAXATION : 1.0f);
+    MarchStats stats = render_sheet(grid, layout, relaxation, pixels);
+    chrono::duration<float> duration = chrono::system_clock::now() - start_time;
+
+    if (COMPARE_RELAXATION) {
+        // SAME SHEET OVER-RELAXED, THE PLAIN ONE IS WRITTEN
+        vector<unsigned char> relaxed_pixels(pixels.size(), 0);
+        chrono::system_clock::time_point relaxed_start = chrono::system_clock::now();
+        MarchStats relaxed = render_sheet(grid, layout, COMPARE_RELAXATION_FACTOR, relaxed_pixels);
+        chrono::duration<float> relaxed_duration = chrono::system_clock::now() - relaxed_start;
+
+        cout << "RELAXATION STEPS: " << (double)stats.steps / stats.rays << " -> " << (double)relaxed.steps / relaxed.rays
+             << " (MAX " << stats.max_steps << " -> " << relaxed.max_steps << ") | " << duration.count() << "s -> " << relaxed_duration.count() << "s"
+             << " | PSNR: " << compute_psnr(pixels, relaxed_pixels) << "dB (PLAIN -> RELAXATION " << COMPARE_RELAXATION_FACTOR << ")" << endl;
+    }
+
+    if (!write_sweep_bitmap(OUTPUT_PATH, pixels.data(), layout.width, layout.height) ||
+        !write_sweep_index(index_path, OUTPUT_PATH, "cpu", SAMPLES, duration.count(), grid, layout))
+    {
+        cout << "FAILED TO WRITE " << OUTPUT_PATH << endl;
+        return -1;
+    }
+
+    cout << "SAVED: " << OUTPUT_PATH << " + " << index_path << endl;
+    cout << "Total time taken: " << sec_to_time(duration.count()) << endl;
+    return 0;
+}
@@ -7,6 +7,8 @@
 #include <sstream>
 #include <chrono>
 
+#include "PreviewServer.h"
+
 using namespace std;
 
 struct vec3 {
@@ -29,6 +31,9 @@ vec3 normalize(const vec3& a) {
     float len = length(a);
     return { a.x / len, a.y / len, a.z / len };
 }
+float dot(const vec3& a, const vec3& b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
 
 const int MAX_FRAMES = 2000;
 
@@ -39,6 +44,18 @@ const int PIXEL_BUFFER_SIZE = FRAME_WIDTH * FRAME_HEIGHT * 3;
 
 const bool SAVE_FRAMES = false;
 
+// STREAM THE VIEW TO http://127.0.0.1:PREVIEW_PORT AND TAKE CAMERA INPUT FROM IT (SEE PreviewServer.h)
+const bool USE_PREVIEW_SERVER = false;
+const int PREVIEW_PORT = 8080;
+
+// ONLY SHADE THE SCREEN RECTANGLE COVERED BY THE BOUNDING SPHERE OF THE SET
+const bool USE_BOUND_CULLING = true;
+const float BOUND_RADIUS = 2.0f;
+
+// DOF SETTINGS (MUST MATCH res/shaders/BasicFreeFly.frag, THE SCISSOR COVERS THE LENS SAMPLES)
+const float FOCAL_LENGTH = 2.920f;
+const float APERTURE = 0.024f;
+
 float mouse_x = 0.0f;
 float mouse_y = 0.0f;
 float mouse_scroll = 0.0f;
@@ -260,6 +277,100 @@ string sec_to_time(float time)
 float radians(float deg) {
     return deg * (3.141f / 180.0f);
 }
+float degrees(float rad) {
+    return rad * (180.0f / 3.141f);
+}
+
+// APPLY A CAMERA SENT TO THE PREVIEW SERVER
+void applyPreviewCamera(const PreviewCamera& camera)
+{
+    cameraPosition = { camera.position[0], camera.position[1], camera.position[2] };
+    fov = camera.fov;
+
+    vec3 forward = { camera.forward[0], camera.forward[1], camera.forward[2] };
+    if (length(forward) > 0.0f) {
+        cameraForward = normalize(forward);
+
+        // Keep yaw / pitch in sync so the next mouse move continues from here
+        cameraPitch = degrees(asin(cameraForward.y));
+        cameraYaw = degrees(atan2(cameraForward.x, cameraForward.z));
+    }
+}
+
+// ROTATE VECTOR BY PITCH THEN YAW (SAME AS rotate_vector IN THE SHADER)
+vec3 rotateVector(const vec3& vector, float pitch, float yaw)
+{
+    float cosPitch = cos(pitch);
+    float sinPitch = sin(pitch);
+    float cosYaw = cos(yaw);
+    float sinYaw = sin(yaw);
+    vec3 rotated = { vector.x, (vector.y * cosPitch) - (vector.z * sinPitch), (vector.y * sinPitch) + (vector.z * cosPitch) };
+    return { (rotated.x * cosYaw) + (rotated.z * sinYaw), rotated.y, (-rotated.x * sinYaw) + (rotated.z * cosYaw) };
+}
+
+// RANGE OF uv ALONG ONE SCREEN AXIS COVERED BY A SPHERE (c = CENTER ALONG THAT AXIS, cz = DEPTH)
+bool sphereUvRange(float c, float cz, float radius, float tanHalfFov, float& uvMin, float& uvMax)
+{
+    float a = cz * cz - radius * radius;
+    if (cz <= 0.0f || a <= 0.0f)
+        return false;
+
+    float root = radius * sqrt(c * c + a);
+    uvMin = (c * cz - root) / a / tanHalfFov;
+    uvMax = (c * cz + root) / a / tanHalfFov;
+    return true;
+}
+
+// SCISSOR THE VIEW TO THE PROJECTED BOUNDING SPHERE, FALSE WHEN NOTHING IS VISIBLE
+bool projectBoundingSphere(int& x, int& y, int& width, int& height)
+{
+    x = 0;
+    y = 0;
+    width = FRAME_WIDTH;
+    height = FRAME_HEIGHT;
+
+    // DOF rays leave up to one aperture corner away from the pinhole ray
+    vec3 toCenter = { -cameraPosition.x, -cameraPosition.y, -cameraPosition.z };
+    float distance = length(toCenter);
+    float apertureSpread = APERTURE * sqrt(2.0f) * max(1.0f, (distance + BOUND_RADIUS) / FOCAL_LENGTH);
+    float radius = BOUND_RADIUS + apertureSpread;
+    if (distance <= radius)
+        return true;
+
+    // Camera basis of the shader: rays are rotate_vector((nx, ny, -1), pitch, yaw)
+    vec3 forward = normalize(cameraForward);
+    float pitch = asin(-forward.y);
+    float yaw = atan2(forward.x, forward.z);
+    vec3 right = rotateVector({ 1.0f, 0.0f, 0.0f }, pitch, yaw);
+    vec3 up = rotateVector({ 0.0f, 1.0f, 0.0f }, pitch, yaw);
+    vec3 view = rotateVector({ 0.0f, 0.0f, -1.0f }, pitch, yaw);
+
+    float cx = dot(toCenter, right);
+    float cy = dot(toCenter, up);
+    float cz = dot(toCenter, view);
+    if (cz < -radius)
+        return false;
+
+    float tanHalfFov = tan(radians(fov) * 0.5f);
+    float uMin, uMax, vMin, vMax;
+    if (!sphereUvRange(cx, cz, radius, tanHalfFov, uMin, uMax) ||
+        !sphereUvRange(cy, cz, radius, tanHalfFov, vMin, vMax))
+        return true;
+
+    // uv spans -1..1 over the frame, pad one pixel for rasterization
+    int x0 = max((int)floor((uMin + 1.0f) * 0.5f * FRAME_WIDTH) - 1, 0);
+    int x1 = min((int)ceil((uMax + 1.0f) * 0.5f * FRAME_WIDTH) + 1, FRAME_WIDTH);
+    int y0 = max((int)floor((vMin + 1.0f) * 0.5f * FRAME_HEIGHT) - 1, 0);
+    int y1 = min((int)ceil((vMax + 1.0f) * 0.5f * FRAME_HEIGHT) + 1, FRAME_HEIGHT);
+    if (x1 <= x0 || y1 <= y0)
+        return false;
+
+    x = x0;
+    y = y0;
+    width = x1 - x0;
+    height = y1 - y0;
+    return true;
+}
 
 void mouseCallback(GLFWwindow* window, double xpos, double ypos)
 {
@@ -402,7 +513,7 @@ int main(void)
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 2, 0);
 
     // LOAD SHADER
-    ShaderProgramSource source = ParseShader("res/shaders/Basic.frag");
+    ShaderProgramSource source = ParseShader("res/shaders/BasicFreeFly.frag");
 
     cout << "VERTEX" << endl;
     cout << source.VertexSource << endl;
@@ -425,6 +536,17 @@ int main(void)
     // INIT FRAME BUFFER
     GLubyte** frame_buffer = new GLubyte*[MAX_FRAMES];
 
+    // INIT PREVIEW SERVER
+    PreviewServer preview_server;
+    GLubyte* preview_pixels = nullptr;
+    if (USE_PREVIEW_SERVER) {
+        if (start_preview_server(preview_server, PREVIEW_PORT, FRAME_WIDTH, FRAME_HEIGHT, true))
+            cout << "PREVIEW: http://" << PREVIEW_BIND_ADDRESS << ":" << PREVIEW_PORT << "/" << endl;
+        else
+            cout << "FAILED TO START PREVIEW SERVER ON PORT " << PREVIEW_PORT << endl;
+        preview_pixels = new GLubyte[PIXEL_BUFFER_SIZE];
+    }
+
     chrono::system_clock::time_point start_time = chrono::system_clock::now();
 
     cout << "RENDERING FRAMES..." << endl;
@@ -442,6 +564,20 @@ int main(void)
 
         processInput(window);
 
+        if (USE_PREVIEW_SERVER) {
+            // TAKE REMOTE CAMERA INPUT, THEN PUBLISH THE CURRENT CAMERA
+            PreviewCamera remote_camera;
+            if (poll_preview_camera(preview_server, remote_camera))
+                applyPreviewCamera(remote_camera);
+
+            PreviewCamera camera = {
+                { cameraPosition.x, cameraPosition.y, cameraPosition.z },
+                { cameraForward.x, cameraForward.y, cameraForward.z },
+                fov
+            };
+            publish_preview_camera(preview_server, camera);
+        }
+
         // GET TIME
         float timeValue = (float)frame / (float)MAX_FRAMES * 3.141f * 2.0f / 0.132f;
 
@@ -458,8 +594,18 @@ int main(void)
         cout << "FOV: " << fov << " Camera Speed: " << cameraSpeed << endl;
 
         // RENDER FRACTAL
+        glDisable(GL_SCISSOR_TEST);
         glClear(GL_COLOR_BUFFER_BIT);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+
+        int scissorX, scissorY, scissorWidth, scissorHeight;
+        bool visible = projectBoundingSphere(scissorX, scissorY, scissorWidth, scissorHeight);
+        if (USE_BOUND_CULLING) {
+            glEnable(GL_SCISSOR_TEST);
+            glScissor(scissorX, scissorY, scissorWidth, scissorHeight);
+        }
+        if (visible || !USE_BOUND_CULLING)
+            glDrawArrays(GL_TRIANGLES, 0, 6);
+        glDisable(GL_SCISSOR_TEST);
 
         if (SAVE_FRAMES) {
             // ADD PIXELS TO FRAME BUFFEER
@@ -468,6 +614,13 @@ int main(void)
             frame_buffer[frame] = pixels;
         }
 
+        if (USE_PREVIEW_SERVER) {
+            // HAND THE READBACK TO THE PREVIEW ENCODER
+            glPixelStorei(GL_PACK_ALIGNMENT, 1);
+            glReadPixels(0, 0, FRAME_WIDTH, FRAME_HEIGHT, GL_RGB, GL_UNSIGNED_BYTE, preview_pixels);
+            submit_preview_frame(preview_server, preview_pixels, FRAME_WIDTH * 3, false);
+        }
+
         // SWAP FRONT AND BACK BUFFERS
         glfwSwapBuffers(window);
 
@@ -504,6 +657,10 @@ int main(void)
         chrono::duration<float> duration = end_time - start_time;
         cout << "Total time taken: " << sec_to_time(duration.count()) << endl;
     }
+    // STOP PREVIEW SERVER
+    stop_preview_server(preview_server);
+    delete[] preview_pixels;
+
     // DELTE SHADER
     glDeleteProgram(shader);
 
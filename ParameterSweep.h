@@ -0,0 +1,255 @@
+#pragma once
+
+// PARAMETER SWEEP
+// A grid of scene variants (palette, power, camera) rendered as the tiles of
+// one contact sheet. `Application sweep` uploads the grid as a float texture
+// and renders every tile in a single draw call and readback;
+// MandelbulbSweep.cpp renders the same grid on the CPU, one tile per task on
+// all cores. Both write the sheet as a bitmap plus a JSON index that maps
+// every tile rectangle back to its parameters.
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+// TILE SIZE IN PIXELS AND DOF SAMPLES PER PIXEL
+const int SWEEP_TILE_SIZE = 192;
+const int SWEEP_SAMPLES = 8;
+
+// CAMERA ORBIT OF res/shaders/Basic.frag: ANGLE t AROUND A TARGET ON THE UNIT CIRCLE
+const float SWEEP_CAMERA_DISTANCE = 2.920f;
+const float SWEEP_TARGET_ANGLE = -1.592f;
+
+struct SweepPalette {
+    float a[3];
+    float b[3];
+    float c[3];
+    float d[3];
+    float scale;
+    float offset;
+};
+
+// SWEEP AXES, THE GRID IS THEIR CARTESIAN PRODUCT (ONE ROW OF POWERS PER PALETTE / ORBIT)
+const float SWEEP_POWERS[] = { 4.0f, 6.0f, 8.0f, 10.0f, 12.0f, 15.64f };
+const SweepPalette SWEEP_PALETTES[] = {
+    // res/shaders/Basic.frag
+    { { 0.500f, 0.500f, 0.500f }, { 0.500f, 0.500f, 0.500f }, { 1.000f, 1.000f, 1.000f }, { 0.000f, 0.948f, 0.888f }, 0.018f, 2.520f },
+    // res/shaders/BasicFreeFly.frag
+    { { 0.500f, 0.500f, 0.500f }, { 0.500f, 0.500f, 0.500f }, { 1.000f, 1.000f, 1.000f }, { 0.000f, 1.058f, 0.058f }, 0.007f, 2.690f },
+    // Rainbow
+    { { 0.500f, 0.500f, 0.500f }, { 0.500f, 0.500f, 0.500f }, { 1.000f, 1.000f, 1.000f }, { 0.000f, 0.333f, 0.667f }, 0.018f, 2.520f },
+    // Warm
+    { { 0.500f, 0.500f, 0.500f }, { 0.500f, 0.500f, 0.500f }, { 1.000f, 0.700f, 0.400f }, { 0.000f, 0.150f, 0.200f }, 0.018f, 2.520f }
+};
+const float SWEEP_ORBITS[] = { -2.392f, -1.592f, -0.792f };
+
+const int SWEEP_POWER_COUNT = sizeof(SWEEP_POWERS) / sizeof(SWEEP_POWERS[0]);
+const int SWEEP_PALETTE_COUNT = sizeof(SWEEP_PALETTES) / sizeof(SWEEP_PALETTES[0]);
+const int SWEEP_ORBIT_COUNT = sizeof(SWEEP_ORBITS) / sizeof(SWEEP_ORBITS[0]);
+
+// EVERYTHING ONE TILE NEEDS
+struct SweepParameters {
+    int palette;
+    float color_a[3];
+    float color_b[3];
+    float color_c[3];
+    float color_d[3];
+    float color_scale;
+    float color_offset;
+    float power;
+    float orbit;
+    float camera_position[3];
+    float target[3];
+};
+
+struct SweepLayout {
+    int tile_width;
+    int tile_height;
+    int columns;
+    int rows;
+    int width;
+    int height;
+};
+
+// BUILD THE GRID, TILE INDEX 0 IS THE TOP LEFT TILE OF THE SHEET
+inline std::vector<SweepParameters> build_sweep_grid()
+{
+    std::vector<SweepParameters> grid;
+    for (int p = 0; p < SWEEP_PALETTE_COUNT; p++) {
+        for (int o = 0; o < SWEEP_ORBIT_COUNT; o++) {
+            for (int w = 0; w < SWEEP_POWER_COUNT; w++) {
+                const SweepPalette& palette = SWEEP_PALETTES[p];
+                SweepParameters params;
+                params.palette = p;
+                for (int k = 0; k < 3; k++) {
+                    params.color_a[k] = palette.a[k];
+                    params.color_b[k] = palette.b[k];
+                    params.color_c[k] = palette.c[k];
+                    params.color_d[k] = palette.d[k];
+                }
+                params.color_scale = palette.scale;
+                params.color_offset = palette.offset;
+                params.power = SWEEP_POWERS[w];
+                params.orbit = SWEEP_ORBITS[o];
+
+                float target[3] = { std::cos(SWEEP_TARGET_ANGLE), 0.0f, std::sin(SWEEP_TARGET_ANGLE) };
+                float camera[3] = { SWEEP_CAMERA_DISTANCE * std::cos(params.orbit), 0.0f, SWEEP_CAMERA_DISTANCE * std::sin(params.orbit) };
+                for (int k = 0; k < 3; k++) {
+                    params.target[k] = target[k];
+                    params.camera_position[k] = camera[k] + target[k];
+                }
+                grid.push_back(params);
+            }
+        }
+    }
+    return grid;
+}
+
+inline SweepLayout sweep_layout(int count, int columns, int tile_size)
+{
+    SweepLayout layout;
+    layout.tile_width = tile_size;
+    layout.tile_height = tile_size;
+    layout.columns = std::max(std::min(columns, count), 1);
+    layout.rows = std::max((count + layout.columns - 1) / layout.columns, 1);
+    layout.width = layout.columns * tile_size;
+    layout.height = layout.rows * tile_size;
+    return layout;
+}
+
+// GPU UPLOAD: ONE ROW OF SWEEP_TEXELS_PER_TILE RGBA32F TEXELS PER TILE, READ BY res/shaders/Basic.frag
+//   0: color_a, color_scale   1: color_b, color_offset   2: color_c, power
+//   3: color_d                4: camera_position         5: target
+const int SWEEP_TEXELS_PER_TILE = 6;
+
+inline std::vector<float> sweep_texels(const std::vector<SweepParameters>& grid)
+{
+    std::vector<float> texels(grid.size() * SWEEP_TEXELS_PER_TILE * 4, 0.0f);
+    for (size_t i = 0; i < grid.size(); i++) {
+        const SweepParameters& params = grid[i];
+        float* row = &texels[i * SWEEP_TEXELS_PER_TILE * 4];
+        const float* vectors[SWEEP_TEXELS_PER_TILE] = { params.color_a, params.color_b, params.color_c, params.color_d, params.camera_position, params.target };
+        for (int t = 0; t < SWEEP_TEXELS_PER_TILE; t++)
+            for (int k = 0; k < 3; k++)
+                row[t * 4 + k] = vectors[t][k];
+        row[0 * 4 + 3] = params.color_scale;
+        row[1 * 4 + 3] = params.color_offset;
+        row[2 * 4 + 3] = params.power;
+    }
+    return texels;
+}
+
+// WRITE AN RGB SHEET (BOTTOM ROW FIRST, AS READ BACK FROM OPENGL) AS A 24-BIT BITMAP
+inline bool write_sweep_bitmap(const std::string& filename, const unsigned char* pixels, int width, int height)
+{
+    std::ofstream file(filename, std::ios::binary);
+    if (!file)
+        return false;
+
+    int row_size = (width * 3 + 3) & ~3;
+    uint32_t pixel_size = (uint32_t)row_size * (uint32_t)height;
+    uint32_t file_size = 54 + pixel_size;
+
+    unsigned char header[54] = { 'B', 'M' };
+    auto put32 = [&header](int offset, uint32_t value) {
+        for (int i = 0; i < 4; i++)
+            header[offset + i] = (unsigned char)(value >> (8 * i));
+    };
+    put32(2, file_size);
+    put32(10, 54);
+    put32(14, 40);
+    put32(18, (uint32_t)width);
+    put32(22, (uint32_t)height);
+    header[26] = 1;
+    header[28] = 24;
+    put32(34, pixel_size);
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+    std::vector<unsigned char> row(row_size, 0);
+    for (int y = 0; y < height; y++) {
+        const unsigned char* source = pixels + (size_t)y * width * 3;
+        for (int x = 0; x < width; x++) {
+            row[x * 3 + 0] = source[x * 3 + 2];
+            row[x * 3 + 1] = source[x * 3 + 1];
+            row[x * 3 + 2] = source[x * 3 + 0];
+        }
+        file.write(reinterpret_cast<const char*>(row.data()), row_size);
+    }
+    return (bool)file;
+}
+
+// INDEX PATH NEXT TO A SHEET: ITS EXTENSION (IF ANY, AFTER THE LAST / OR \) REPLACED BY .json
+inline std::string sweep_index_path(const std::string& image)
+{
+    size_t separator = image.find_last_of("/\\");
+    size_t dot = image.find_last_of('.');
+    if (dot == std::string::npos || (separator != std::string::npos && dot < separator))
+        return image + ".json";
+    return image.substr(0, dot) + ".json";
+}
+
+// QUOTED JSON STRING
+inline std::string json_string(const std::string& value)
+{
+    std::stringstream out;
+    out << "\"";
+    for (char c : value) {
+        if (c == '"' || c == '\\')
+            out << '\\' << c;
+        else if ((unsigned char)c < 0x20)
+            out << "\\u00" << "0123456789abcdef"[(c >> 4) & 0xf] << "0123456789abcdef"[c & 0xf];
+        else
+            out << c;
+    }
+    out << "\"";
+    return out.str();
+}
+
+// WRITE THE JSON INDEX: SHEET INFO AND ONE ENTRY PER TILE (RECT IN PIXELS FROM THE TOP LEFT)
+inline bool write_sweep_index(const std::string& filename, const std::string& image, const std::string& renderer, int samples, float seconds,
+                              const std::vector<SweepParameters>& grid, const SweepLayout& layout)
+{
+    std::ofstream file(filename);
+    if (!file)
+        return false;
+
+    auto vector3 = [](const float* v) {
+        std::stringstream out;
+        out << "[" << v[0] << ", " << v[1] << ", " << v[2] << "]";
+        return out.str();
+    };
+
+    file << "{\n";
+    file << "  \"image\": " << json_string(image) << ",\n";
+    file << "  \"renderer\": " << json_string(renderer) << ",\n";
+    file << "  \"width\": " << layout.width << ",\n";
+    file << "  \"height\": " << layout.height << ",\n";
+    file << "  \"tile_width\": " << layout.tile_width << ",\n";
+    file << "  \"tile_height\": " << layout.tile_height << ",\n";
+    file << "  \"columns\": " << layout.columns << ",\n";
+    file << "  \"rows\": " << layout.rows << ",\n";
+    file << "  \"samples\": " << samples << ",\n";
+    file << "  \"seconds\": " << seconds << ",\n";
+    file << "  \"tiles\": [\n";
+    for (size_t i = 0; i < grid.size(); i++) {
+        const SweepParameters& params = grid[i];
+        int column = (int)i % layout.columns;
+        int row = (int)i / layout.columns;
+        file << "    { \"index\": " << i
+             << ", \"x\": " << column * layout.tile_width << ", \"y\": " << row * layout.tile_height
+             << ", \"palette\": " << params.palette
+             << ", \"color_a\": " << vector3(params.color_a) << ", \"color_b\": " << vector3(params.color_b)
+             << ", \"color_c\": " << vector3(params.color_c) << ", \"color_d\": " << vector3(params.color_d)
+             << ", \"color_scale\": " << params.color_scale << ", \"color_offset\": " << params.color_offset
+             << ", \"power\": " << params.power << ", \"orbit\": " << params.orbit
+             << ", \"camera_position\": " << vector3(params.camera_position) << ", \"target\": " << vector3(params.target)
+             << " }" << (i + 1 < grid.size() ? "," : "") << "\n";
+    }
+    file << "  ]\n";
+    file << "}\n";
+    return (bool)file;
+}
@@ -0,0 +1,717 @@
+#pragma once
+
+// LOCAL PREVIEW SERVER
+// Streams downscaled frames over HTTP as multipart/x-mixed-replace (the
+// MJPEG mechanism, with bitmap parts) and accepts camera updates.
+//
+//   GET /         viewer page
+//   GET /stream   live frames
+//   GET /frame    latest frame
+//   GET /camera   current camera as JSON
+//   POST /camera  update it with any of ?px=&py=&pz= (position)
+//                 ?fx=&fy=&fz= (forward) ?fov=, returns the new camera
+//
+// /camera and the page's camera controls only exist when the host takes
+// camera input (start_preview_server(..., camera_input = true)). Requests
+// must address a loopback Host, and camera updates from a browser must
+// come from the preview page's own origin, so other web pages and DNS
+// rebinding can not drive the camera.
+//
+// The render loop only copies its readback into a slot, a worker thread
+// downscales and encodes the latest frame, and every client thread sends
+// the newest encoded frame, so slow clients drop frames instead of
+// stalling the renderer. The downscale factor adapts to keep the time
+// from submit to sent under PREVIEW_LATENCY_MS.
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "Ws2_32.lib")
+typedef SOCKET preview_socket;
+#define INVALID_PREVIEW_SOCKET INVALID_SOCKET
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+typedef int preview_socket;
+#define INVALID_PREVIEW_SOCKET -1
+#endif
+
+#include <string>
+#include <sstream>
+#include <vector>
+#include <list>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+#include <cstdint>
+
+// ONLY LISTEN ON LOOPBACK, TUNNEL (e.g. ssh -L) TO WATCH FROM ANOTHER MACHINE
+const char* const PREVIEW_BIND_ADDRESS = "127.0.0.1";
+
+// LARGEST STREAMED WIDTH AND THE LATENCY THE ADAPTIVE DOWNSCALE AIMS FOR
+const int PREVIEW_MAX_WIDTH = 512;
+const int PREVIEW_MAX_EXTRA_SCALE = 4;
+const float PREVIEW_LATENCY_MS = 100.0f;
+
+// SEND 8-BIT RUN-LENGTH ENCODED PARTS ON A RED x GREEN x BLUE COLOR CUBE, WHICH
+// BROWSERS DECODE NATIVELY; false SENDS UNCOMPRESSED 24-BIT PARTS
+const bool PREVIEW_COMPRESS = true;
+const int PREVIEW_CUBE_RED = 6;
+const int PREVIEW_CUBE_GREEN = 7;
+const int PREVIEW_CUBE_BLUE = 6;
+
+struct PreviewCamera {
+    float position[3];
+    float forward[3];
+    float fov;
+};
+
+struct PreviewClient {
+    preview_socket socket;
+    std::thread worker;
+    std::atomic<bool> done{ false };
+};
+
+struct PreviewServer {
+    int width = 0;
+    int height = 0;
+    preview_socket listen_socket = INVALID_PREVIEW_SOCKET;
+    std::atomic<bool> running{ false };
+    std::thread accept_thread;
+    std::thread encode_thread;
+
+    std::mutex clients_mutex;
+    std::list<std::unique_ptr<PreviewClient>> clients;
+
+    // RAW FRAME HANDED OVER BY THE RENDER LOOP (LATEST ONLY)
+    std::mutex raw_mutex;
+    std::condition_variable raw_ready;
+    std::vector<unsigned char> raw_pixels;
+    bool raw_bgr = false;
+    bool raw_pending = false;
+    std::chrono::steady_clock::time_point raw_time;
+
+    // ENCODED FRAME SHARED BY ALL CLIENTS
+    std::mutex frame_mutex;
+    std::condition_variable frame_ready;
+    std::shared_ptr<const std::string> frame;
+    uint64_t frame_sequence = 0;
+    std::chrono::steady_clock::time_point frame_time;
+
+    // DOWNSCALE FACTOR, ADAPTED BETWEEN min_scale AND max_scale
+    std::atomic<int> scale{ 1 };
+    int min_scale = 1;
+    int max_scale = 1;
+
+    // CAMERA PUBLISHED BY THE HOST AND UPDATES REQUESTED BY CLIENTS
+    bool camera_input = false;
+    std::mutex camera_mutex;
+    PreviewCamera camera = { { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, 0.0f };
+    bool camera_pending = false;
+};
+
+static void close_preview_socket(preview_socket socket)
+{
+#ifdef _WIN32
+    closesocket(socket);
+#else
+    close(socket);
+#endif
+}
+
+static void shutdown_preview_socket(preview_socket socket)
+{
+#ifdef _WIN32
+    shutdown(socket, SD_BOTH);
+#else
+    shutdown(socket, SHUT_RDWR);
+#endif
+}
+
+static bool send_all(preview_socket socket, const char* data, size_t size)
+{
+#ifdef MSG_NOSIGNAL
+    int flags = MSG_NOSIGNAL;
+#else
+    int flags = 0;
+#endif
+    while (size > 0) {
+        int sent = (int)send(socket, data, (int)std::min(size, (size_t)1 << 20), flags);
+        if (sent <= 0)
+            return false;
+        data += sent;
+        size -= sent;
+    }
+    return true;
+}
+static bool send_all(preview_socket socket, const std::string& data)
+{
+    return send_all(socket, data.data(), data.size());
+}
+
+// BOX FILTER DOWNSCALE TO BGR ROWS (INPUT ROWS ARE BOTTOM-UP LIKE glReadPixels, AS ARE BITMAP ROWS)
+static std::vector<unsigned char> downscale_preview(const unsigned char* pixels, int width, bool bgr, int scale, int out_width, int out_height)
+{
+    std::vector<unsigned char> out((size_t)out_width * out_height * 3);
+    int row_stride = width * 3;
+    int area = scale * scale;
+    for (int y = 0; y < out_height; y++) {
+        unsigned char* row = &out[(size_t)y * out_width * 3];
+        for (int x = 0; x < out_width; x++) {
+            int sum[3] = { 0, 0, 0 };
+            for (int sy = 0; sy < scale; sy++) {
+                const unsigned char* in = pixels + (size_t)(y * scale + sy) * row_stride + x * scale * 3;
+                for (int sx = 0; sx < scale; sx++) {
+                    sum[0] += in[sx * 3];
+                    sum[1] += in[sx * 3 + 1];
+                    sum[2] += in[sx * 3 + 2];
+                }
+            }
+            // Bitmaps store BGR
+            row[x * 3] = (unsigned char)(sum[bgr ? 0 : 2] / area);
+            row[x * 3 + 1] = (unsigned char)(sum[1] / area);
+            row[x * 3 + 2] = (unsigned char)(sum[bgr ? 2 : 0] / area);
+        }
+    }
+    return out;
+}
+
+// BITMAPFILEHEADER + BITMAPINFOHEADER
+static void put_preview_bitmap_header(unsigned char* data, int file_size, int pixel_offset, int width, int height, int bits, int compression, int image_size, int colors)
+{
+    auto put32 = [data](int offset, int value) {
+        data[offset] = (unsigned char)(value);
+        data[offset + 1] = (unsigned char)(value >> 8);
+        data[offset + 2] = (unsigned char)(value >> 16);
+        data[offset + 3] = (unsigned char)(value >> 24);
+    };
+    data[0] = 'B';
+    data[1] = 'M';
+    put32(2, file_size);
+    put32(10, pixel_offset);
+    put32(14, 40);
+    put32(18, width);
+    put32(22, height);
+    data[26] = 1;
+    data[28] = (unsigned char)bits;
+    put32(30, compression);
+    put32(34, image_size);
+    put32(46, colors);
+}
+
+// RUN-LENGTH ENCODE ONE ROW OF PALETTE INDICES (BI_RLE8): REPEATS AS (count, index)
+// PAIRS, OTHER STRETCHES AS ABSOLUTE RUNS (0, count, indices, PADDED TO A WORD)
+static void encode_rle8_row(const unsigned char* row, int width, std::string& out)
+{
+    int x = 0;
+    while (x < width) {
+        int run = 1;
+        while (x + run < width && run < 255 && row[x + run] == row[x])
+            run++;
+        if (run > 1) {
+            out += (char)run;
+            out += (char)row[x];
+            x += run;
+            continue;
+        }
+
+        // Literal stretch up to the next repeat
+        int literal = 1;
+        while (x + literal < width && literal < 255 && !(x + literal + 1 < width && row[x + literal] == row[x + literal + 1]))
+            literal++;
+        if (literal < 3) {
+            // Absolute runs are at least 3 long, shorter ones are single repeats
+            for (int i = 0; i < literal; i++) {
+                out += (char)1;
+                out += (char)row[x + i];
+            }
+        }
+        else {
+            out += (char)0;
+            out += (char)literal;
+            out.append((const char*)row + x, literal);
+            if (literal & 1)
+                out += (char)0;
+        }
+        x += literal;
+    }
+}
+
+// 8-BIT BITMAP ON THE PREVIEW COLOR CUBE, RUN-LENGTH ENCODED
+static std::string encode_preview_rle8(const std::vector<unsigned char>& bgr, int width, int height)
+{
+    const int colors = PREVIEW_CUBE_RED * PREVIEW_CUBE_GREEN * PREVIEW_CUBE_BLUE;
+    const int pixel_offset = 54 + colors * 4;
+
+    std::string bitmap(pixel_offset, '\0');
+    bitmap.reserve(pixel_offset + (size_t)width * height / 2);
+    unsigned char* palette = (unsigned char*)&bitmap[54];
+    for (int r = 0; r < PREVIEW_CUBE_RED; r++)
+        for (int g = 0; g < PREVIEW_CUBE_GREEN; g++)
+            for (int b = 0; b < PREVIEW_CUBE_BLUE; b++) {
+                unsigned char* entry = palette + ((r * PREVIEW_CUBE_GREEN + g) * PREVIEW_CUBE_BLUE + b) * 4;
+                entry[0] = (unsigned char)(b * 255 / (PREVIEW_CUBE_BLUE - 1));
+                entry[1] = (unsigned char)(g * 255 / (PREVIEW_CUBE_GREEN - 1));
+                entry[2] = (unsigned char)(r * 255 / (PREVIEW_CUBE_RED - 1));
+            }
+
+    std::vector<unsigned char> indices(width);
+    for (int y = 0; y < height; y++) {
+        const unsigned char* row = &bgr[(size_t)y * width * 3];
+        for (int x = 0; x < width; x++) {
+            int b = (row[x * 3] * (PREVIEW_CUBE_BLUE - 1) + 127) / 255;
+            int g = (row[x * 3 + 1] * (PREVIEW_CUBE_GREEN - 1) + 127) / 255;
+            int r = (row[x * 3 + 2] * (PREVIEW_CUBE_RED - 1) + 127) / 255;
+            indices[x] = (unsigned char)((r * PREVIEW_CUBE_GREEN + g) * PREVIEW_CUBE_BLUE + b);
+        }
+        encode_rle8_row(indices.data(), width, bitmap);
+
+        // End of line, end of bitmap after the last one
+        bitmap += (char)0;
+        bitmap += (char)(y + 1 < height ? 0 : 1);
+    }
+
+    put_preview_bitmap_header((unsigned char*)&bitmap[0], (int)bitmap.size(), pixel_offset, width, height, 8, 1, (int)bitmap.size() - pixel_offset, colors);
+    return bitmap;
+}
+
+// UNCOMPRESSED 24-BIT BITMAP
+static std::string encode_preview_rgb(const std::vector<unsigned char>& bgr, int width, int height)
+{
+    int row_size = (width * 3 + 3) & ~3;
+    int file_size = 54 + row_size * height;
+
+    std::string bitmap(file_size, '\0');
+    unsigned char* data = (unsigned char*)&bitmap[0];
+    put_preview_bitmap_header(data, file_size, 54, width, height, 24, 0, row_size * height, 0);
+    for (int y = 0; y < height; y++)
+        memcpy(data + 54 + y * row_size, &bgr[(size_t)y * width * 3], width * 3);
+    return bitmap;
+}
+
+// DOWNSCALE AND ENCODE ONE PREVIEW PART
+static std::string encode_preview_bitmap(const unsigned char* pixels, int width, int height, bool bgr, int scale)
+{
+    int out_width = std::max(width / scale, 1);
+    int out_height = std::max(height / scale, 1);
+    std::vector<unsigned char> downscaled = downscale_preview(pixels, width, bgr, scale, out_width, out_height);
+    if (PREVIEW_COMPRESS)
+        return encode_preview_rle8(downscaled, out_width, out_height);
+    return encode_preview_rgb(downscaled, out_width, out_height);
+}
+
+// WORKER: ENCODE THE LATEST SUBMITTED FRAME
+static void preview_encode_loop(PreviewServer* server)
+{
+    std::vector<unsigned char> pixels;
+    while (true) {
+        bool bgr;
+        std::chrono::steady_clock::time_point submitted;
+        {
+            std::unique_lock<std::mutex> lock(server->raw_mutex);
+            server->raw_ready.wait(lock, [server] { return server->raw_pending || !server->running; });
+            if (!server->running)
+                return;
+            pixels.swap(server->raw_pixels);
+            bgr = server->raw_bgr;
+            submitted = server->raw_time;
+            server->raw_pending = false;
+        }
+
+        std::shared_ptr<const std::string> encoded = std::make_shared<const std::string>(
+            encode_preview_bitmap(pixels.data(), server->width, server->height, bgr, server->scale));
+
+        {
+            std::lock_guard<std::mutex> lock(server->frame_mutex);
+            server->frame = encoded;
+            server->frame_time = submitted;
+            server->frame_sequence++;
+        }
+        server->frame_ready.notify_all();
+    }
+}
+
+static std::string camera_json(const PreviewCamera& camera)
+{
+    std::stringstream ss;
+    ss << "{\"position\":[" << camera.position[0] << "," << camera.position[1] << "," << camera.position[2] << "],"
+       << "\"forward\":[" << camera.forward[0] << "," << camera.forward[1] << "," << camera.forward[2] << "],"
+       << "\"fov\":" << camera.fov << "}";
+    return ss.str();
+}
+
+// APPLY px=..&fz=..&fov=.. STYLE QUERY PARAMETERS, RETURNS FALSE WHEN NONE MATCHED
+static bool parse_camera_query(const std::string& query, PreviewCamera& camera)
+{
+    bool changed = false;
+    std::stringstream ss(query);
+    std::string pair;
+    while (getline(ss, pair, '&')) {
+        size_t equals = pair.find('=');
+        if (equals == std::string::npos)
+            continue;
+        std::string key = pair.substr(0, equals);
+        float value = (float)atof(pair.substr(equals + 1).c_str());
+
+        float* target = nullptr;
+        if (key == "px") target = &camera.position[0];
+        else if (key == "py") target = &camera.position[1];
+        else if (key == "pz") target = &camera.position[2];
+        else if (key == "fx") target = &camera.forward[0];
+        else if (key == "fy") target = &camera.forward[1];
+        else if (key == "fz") target = &camera.forward[2];
+        else if (key == "fov") target = &camera.fov;
+
+        if (target) {
+            *target = value;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+static const char* PREVIEW_PAGE =
+    "<!DOCTYPE html><html><head><title>Mandelbulb preview</title></head>"
+    "<body style=\"background:#000;color:#ccc;font-family:monospace\">"
+    "<img src=\"/stream\" style=\"height:90vh;image-rendering:pixelated\"><br>";
+
+static const char* PREVIEW_CAMERA_CONTROLS =
+    "<span id=\"camera\"></span>"
+    "<script>"
+    "let cam=null;"
+    "function show(c){cam=c;document.getElementById('camera').textContent=JSON.stringify(c);}"
+    "fetch('/camera').then(r=>r.json()).then(show);"
+    "document.onkeydown=e=>{if(!cam)return;let s=0.03,f=cam.forward,p=cam.position;"
+    "let r=[f[2],0,-f[0]];let k=e.key.toLowerCase();"
+    "if(k=='w')p=p.map((v,i)=>v-f[i]*s);if(k=='s')p=p.map((v,i)=>v+f[i]*s);"
+    "if(k=='a')p=p.map((v,i)=>v-r[i]*s);if(k=='d')p=p.map((v,i)=>v+r[i]*s);"
+    "if(k=='e')p[1]+=s;if(k=='q')p[1]-=s;"
+    "let fov=cam.fov+(k=='x'?0.5:k=='z'?-0.5:0);"
+    "fetch(`/camera?px=${p[0]}&py=${p[1]}&pz=${p[2]}&fov=${fov}`,{method:'POST'}).then(r=>r.json()).then(show);};"
+    "</script>";
+
+static const char* PREVIEW_PAGE_END = "</body></html>";
+
+// VALUE OF A REQUEST HEADER (CASE INSENSITIVE NAME), EMPTY WHEN MISSING
+static std::string preview_request_header(const std::string& request, const char* name)
+{
+    size_t name_length = strlen(name);
+    size_t line_start = request.find("\r\n");
+    while (line_start != std::string::npos) {
+        line_start += 2;
+        size_t line_end = request.find("\r\n", line_start);
+        if (line_end == std::string::npos || line_end == line_start)
+            break;
+        std::string line = request.substr(line_start, line_end - line_start);
+        if (line.size() > name_length && line[name_length] == ':') {
+            bool match = true;
+            for (size_t i = 0; i < name_length && match; i++)
+                match = tolower((unsigned char)line[i]) == tolower((unsigned char)name[i]);
+            if (match) {
+                size_t value = line.find_first_not_of(" \t", name_length + 1);
+                return value == std::string::npos ? "" : line.substr(value);
+            }
+        }
+        line_start = line_end;
+    }
+    return "";
+}
+
+// TRUE FOR A Host HEADER NAMING THE LOOPBACK INTERFACE (ANY PORT, FOR TUNNELS)
+static bool is_loopback_host(const std::string& host)
+{
+    std::string name = host.substr(0, host.find(':'));
+    return name == "127.0.0.1" || name == "localhost";
+}
+
+static std::string http_header(const char* status, const char* content_type, size_t length)
+{
+    std::stringstream ss;
+    ss << "HTTP/1.1 " << status << "\r\n"
+       << "Content-Type: " << content_type << "\r\n"
+       << "Content-Length: " << length << "\r\n"
+       << "Cache-Control: no-cache\r\n"
+       << "Connection: close\r\n\r\n";
+    return ss.str();
+}
+
+// SEND FRAMES UNTIL THE CLIENT GOES AWAY, ADAPTING THE DOWNSCALE TO THE LATENCY
+static void preview_stream(PreviewServer* server, preview_socket socket)
+{
+    std::string header =
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: multipart/x-mixed-replace; boundary=frame\r\n"
+        "Cache-Control: no-cache\r\n"
+        "Connection: close\r\n\r\n";
+    if (!send_all(socket, header))
+        return;
+
+    uint64_t sent_sequence = 0;
+    while (server->running) {
+        std::shared_ptr<const std::string> frame;
+        std::chrono::steady_clock::time_point submitted;
+        {
+            std::unique_lock<std::mutex> lock(server->frame_mutex);
+            server->frame_ready.wait(lock, [server, sent_sequence] { return server->frame_sequence != sent_sequence || !server->running; });
+            if (!server->running)
+                return;
+            frame = server->frame;
+            submitted = server->frame_time;
+            sent_sequence = server->frame_sequence;
+        }
+
+        std::stringstream part;
+        part << "--frame\r\nContent-Type: image/bmp\r\nContent-Length: " << frame->size() << "\r\n\r\n";
+        if (!send_all(socket, part.str()) || !send_all(socket, *frame) || !send_all(socket, "\r\n", 2))
+            return;
+
+        // Latency from submit to sent drives the downscale factor
+        std::chrono::duration<float, std::milli> latency = std::chrono::steady_clock::now() - submitted;
+        int scale = server->scale;
+        if (latency.count() > PREVIEW_LATENCY_MS && scale < server->max_scale)
+            server->scale = scale + 1;
+        else if (latency.count() < PREVIEW_LATENCY_MS / 3.0f && scale > server->min_scale)
+            server->scale = scale - 1;
+    }
+}
+
+static void preview_handle_client(PreviewServer* server, PreviewClient* client)
+{
+    // READ REQUEST HEAD
+    std::string request;
+    char chunk[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < 8192) {
+        int received = (int)recv(client->socket, chunk, sizeof(chunk), 0);
+        if (received <= 0)
+            break;
+        request.append(chunk, received);
+    }
+
+    // PARSE "GET /path?query HTTP/1.1"
+    std::stringstream line(request.substr(0, request.find("\r\n")));
+    std::string method, target;
+    line >> method >> target;
+    size_t question = target.find('?');
+    std::string path = target.substr(0, question);
+    std::string query = question == std::string::npos ? "" : target.substr(question + 1);
+
+    std::string host = preview_request_header(request, "Host");
+    std::string origin = preview_request_header(request, "Origin");
+
+    if (!is_loopback_host(host)) {
+        send_all(client->socket, http_header("403 Forbidden", "text/plain", 0));
+    }
+    else if (path == "/camera" && !server->camera_input) {
+        send_all(client->socket, http_header("404 Not Found", "text/plain", 0));
+    }
+    else if (path == "/camera" && method == "POST") {
+        // Other pages can send simple cross-origin POSTs, only accept our own
+        if (!origin.empty() && origin != "http://" + host) {
+            send_all(client->socket, http_header("403 Forbidden", "text/plain", 0));
+        }
+        else {
+            std::string json;
+            {
+                std::lock_guard<std::mutex> lock(server->camera_mutex);
+                if (parse_camera_query(query, server->camera))
+                    server->camera_pending = true;
+                json = camera_json(server->camera);
+            }
+            send_all(client->socket, http_header("200 OK", "application/json", json.size()) + json);
+        }
+    }
+    else if (method != "GET") {
+        send_all(client->socket, http_header("405 Method Not Allowed", "text/plain", 0));
+    }
+    else if (path == "/") {
+        std::string page = PREVIEW_PAGE;
+        if (server->camera_input)
+            page += PREVIEW_CAMERA_CONTROLS;
+        page += PREVIEW_PAGE_END;
+        send_all(client->socket, http_header("200 OK", "text/html", page.size()) + page);
+    }
+    else if (path == "/stream") {
+        preview_stream(server, client->socket);
+    }
+    else if (path == "/frame") {
+        std::shared_ptr<const std::string> frame;
+        {
+            std::lock_guard<std::mutex> lock(server->frame_mutex);
+            frame = server->frame;
+        }
+        if (frame)
+            send_all(client->socket, http_header("200 OK", "image/bmp", frame->size()) + *frame);
+        else
+            send_all(client->socket, http_header("503 Service Unavailable", "text/plain", 0));
+    }
+    else if (path == "/camera") {
+        std::string json;
+        {
+            std::lock_guard<std::mutex> lock(server->camera_mutex);
+            json = camera_json(server->camera);
+        }
+        send_all(client->socket, http_header("200 OK", "application/json", json.size()) + json);
+    }
+    else {
+        send_all(client->socket, http_header("404 Not Found", "text/plain", 0));
+    }
+
+    // The socket is closed by whoever joins this client
+    shutdown_preview_socket(client->socket);
+    client->done = true;
+}
+
+static void preview_accept_loop(PreviewServer* server)
+{
+    while (server->running) {
+        preview_socket socket = accept(server->listen_socket, nullptr, nullptr);
+        if (socket == INVALID_PREVIEW_SOCKET)
+            continue;
+
+        std::lock_guard<std::mutex> lock(server->clients_mutex);
+
+        // Join finished clients
+        for (auto it = server->clients.begin(); it != server->clients.end();) {
+            if ((*it)->done) {
+                (*it)->worker.join();
+                close_preview_socket((*it)->socket);
+                it = server->clients.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+
+        if (!server->running) {
+            close_preview_socket(socket);
+            break;
+        }
+
+        std::unique_ptr<PreviewClient> client(new PreviewClient());
+        client->socket = socket;
+        client->worker = std::thread(preview_handle_client, server, client.get());
+        server->clients.push_back(std::move(client));
+    }
+}
+
+// START LISTENING ON PREVIEW_BIND_ADDRESS:port FOR width x height FRAMES
+// camera_input: THE HOST POLLS poll_preview_camera, SO SERVE /camera AND THE PAGE CONTROLS
+static bool start_preview_server(PreviewServer& server, int port, int width, int height, bool camera_input)
+{
+#ifdef _WIN32
+    WSADATA wsa_data;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0)
+        return false;
+#endif
+
+    server.listen_socket = socket(AF_INET, SOCK_STREAM, 0);
+    if (server.listen_socket == INVALID_PREVIEW_SOCKET)
+        return false;
+
+    int reuse = 1;
+    setsockopt(server.listen_socket, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons((unsigned short)port);
+    inet_pton(AF_INET, PREVIEW_BIND_ADDRESS, &address.sin_addr);
+
+    if (bind(server.listen_socket, (sockaddr*)&address, sizeof(address)) != 0 || listen(server.listen_socket, 8) != 0) {
+        close_preview_socket(server.listen_socket);
+        server.listen_socket = INVALID_PREVIEW_SOCKET;
+        return false;
+    }
+
+    server.width = width;
+    server.height = height;
+    server.camera_input = camera_input;
+    server.min_scale = std::max((width + PREVIEW_MAX_WIDTH - 1) / PREVIEW_MAX_WIDTH, 1);
+    server.max_scale = server.min_scale * PREVIEW_MAX_EXTRA_SCALE;
+    server.scale = server.min_scale;
+
+    server.running = true;
+    server.encode_thread = std::thread(preview_encode_loop, &server);
+    server.accept_thread = std::thread(preview_accept_loop, &server);
+    return true;
+}
+
+static void stop_preview_server(PreviewServer& server)
+{
+    if (!server.running)
+        return;
+
+    // Wake every thread: waiting workers via the flags, blocked sockets via shutdown
+    {
+        std::lock_guard<std::mutex> raw_lock(server.raw_mutex);
+        std::lock_guard<std::mutex> frame_lock(server.frame_mutex);
+        server.running = false;
+    }
+    server.raw_ready.notify_all();
+    server.frame_ready.notify_all();
+
+    shutdown_preview_socket(server.listen_socket);
+    close_preview_socket(server.listen_socket);
+    server.accept_thread.join();
+    server.encode_thread.join();
+
+    std::lock_guard<std::mutex> lock(server.clients_mutex);
+    for (std::unique_ptr<PreviewClient>& client : server.clients) {
+        shutdown_preview_socket(client->socket);
+        client->worker.join();
+        close_preview_socket(client->socket);
+    }
+    server.clients.clear();
+
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+// HAND A READBACK (BOTTOM-UP ROWS OF row_stride BYTES) TO THE ENCODER, REPLACING ANY UNENCODED ONE
+static void submit_preview_frame(PreviewServer& server, const unsigned char* pixels, int row_stride, bool bgr)
+{
+    if (!server.running)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(server.raw_mutex);
+        int row_size = server.width * 3;
+        server.raw_pixels.resize((size_t)row_size * server.height);
+        for (int y = 0; y < server.height; y++)
+            memcpy(&server.raw_pixels[(size_t)y * row_size], pixels + (size_t)y * row_stride, row_size);
+        server.raw_bgr = bgr;
+        server.raw_time = std::chrono::steady_clock::now();
+        server.raw_pending = true;
+    }
+    server.raw_ready.notify_one();
+}
+
+// SHOW THE HOST CAMERA ON /camera
+static void publish_preview_camera(PreviewServer& server, const PreviewCamera& camera)
+{
+    std::lock_guard<std::mutex> lock(server.camera_mutex);
+    if (!server.camera_pending)
+        server.camera = camera;
+}
+
+// TAKE A CAMERA UPDATE SENT BY A CLIENT, RETURNS FALSE WHEN THERE IS NONE
+static bool poll_preview_camera(PreviewServer& server, PreviewCamera& camera)
+{
+    std::lock_guard<std::mutex> lock(server.camera_mutex);
+    if (!server.camera_pending)
+        return false;
+    camera = server.camera;
+    server.camera_pending = false;
+    return true;
+}
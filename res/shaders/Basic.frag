@@ -14,13 +14,45 @@ void main()
 #version 330 core
 
 layout(location = 0) out vec4 color;
+layout(location = 1) out vec4 guide;
 in vec2 fragPosition;
 uniform float u_time;
+uniform int u_samples;
+uniform vec2 u_resolution;
+uniform int u_exact;
+uniform int u_lod;  // 1 TURNS LOD ON EVEN WHEN USE_LOD IS false (HEATMAP COMPARISON)
+uniform float u_relaxation;
+uniform int u_unbounded;
+uniform int u_heatmap;
+
+// PARAMETER SWEEP: u_sweep TILES OF u_resolution PIXELS IN A u_sweep_grid (COLUMNS, ROWS) ATLAS,
+// TILE i READS ITS PARAMETERS FROM ROW i OF u_sweep_params (LAYOUT IN ParameterSweep.h)
+uniform int u_sweep;
+uniform ivec2 u_sweep_grid;
+uniform sampler2D u_sweep_params;
 
 #define MAX_ITERS 500
+#define MAX_ITERS_MARCH 500
 #define EPSILON 0.0001
 #define MAX_DISTANCE 100.0
 
+// EVERY POINT OUTSIDE THIS RADIUS ESCAPES ON THE FIRST ITERATION (r > 2.0)
+#define BOUND_RADIUS 2.0
+
+// LOD: HIT EPSILON FOLLOWS THE PIXEL FOOTPRINT, ESCAPE ITERATIONS FOLLOW EPSILON ONCE IT
+// IS ABOVE EPSILON, MARCH STEPS FOLLOW THE FOOTPRINT (OFF UNTIL CHECKED WITH THE HEATMAP)
+#define USE_LOD false
+#define LOD_PIXEL_SCALE 0.5
+#define LOD_ITERS_SCALE 2.0
+#define LOD_ITERS_MARGIN 8.0
+#define LOD_STEPS_SCALE 16.0
+#define LOD_STEPS_MARGIN 64.0
+
+// OVER-RELAXED SPHERE TRACING: STEP RELAXATION * dist, FALL BACK TO A SAFE
+// STEP WHEN CONSECUTIVE UNBOUNDING SPHERES STOP OVERLAPPING
+#define USE_OVER_RELAXATION false
+#define RELAXATION 1.6
+
 #define TIME_SCALE 1.0
 #define TIME_OFFSET 5.616
 
@@ -46,24 +78,58 @@ struct GetAngleBetVecRet {
     vec3 axis;
 };
 
+// SCENE PARAMETERS, REPLACED BY THE TILE PARAMETERS IN A SWEEP
+vec3 color_a = vec3(COLOR_A);
+vec3 color_b = vec3(COLOR_B);
+vec3 color_c = vec3(COLOR_C);
+vec3 color_d = vec3(COLOR_D);
+float color_scale = COLOR_SCALE;
+float color_offset = COLOR_OFFSET;
+float sweep_power = 0.0;
+
 // COLOR PALETTE
 vec3 palette(float t) {
-    vec3 a = vec3(COLOR_A);
-    vec3 b = vec3(COLOR_B);
-    vec3 c = vec3(COLOR_C);
-    vec3 d = vec3(COLOR_D);
+    vec3 a = color_a;
+    vec3 b = color_b;
+    vec3 c = color_c;
+    vec3 d = color_d;
     return a + b*cos(6.28318*(c*t+d));
 }
 
+// ESCAPE ITERATIONS SPENT BY ALL DISTANCE CALLS (FOR THE HEATMAP)
+float escape_iters_taken = 0.0;
+
+// MANDEL BULB POWER
+float bulb_power() {
+    if (sweep_power > 0.0)
+        return sweep_power;
+    float max_pow = 11.640;
+    return (((sin(u_time * 0.132 * TIME_SCALE + TIME_OFFSET) + 1.0) / 2.0) * max_pow) + 4.0;
+}
+
+// ESCAPE ITERATIONS NEEDED TO RESOLVE THE SURFACE TO WITHIN eps
+int escape_budget(float eps, float power) {
+    float needed = LOD_ITERS_MARGIN + LOD_ITERS_SCALE * log(1.0 / eps) / log(power);
+    return min(int(needed), MAX_ITERS);
+}
+
+// MARCH STEPS NEEDED TO CLOSE IN ON THE SURFACE TO THE PIXEL FOOTPRINT
+// Each step shrinks the remaining distance by a roughly constant factor,
+// so the count grows with the log of distance over footprint
+int march_budget(float pixel_cone) {
+    if (pixel_cone <= 0.0)
+        return MAX_ITERS_MARCH;
+    float needed = LOD_STEPS_MARGIN + LOD_STEPS_SCALE * log(1.0 / (pixel_cone * LOD_PIXEL_SCALE));
+    return min(int(needed), MAX_ITERS_MARCH);
+}
+
 // MANDEL BULB SIGNED DISTANCE FUNCTION
-float mandelbulb_distance(vec3 point) {
+float mandelbulb_distance(vec3 point, float power, int max_iters) {
     vec3 z = point;
     float dr = 1.0;
     float r = 0.0;
-    float max_pow = 11.640;
-    float power = (((sin(u_time * 0.132 * TIME_SCALE + TIME_OFFSET) + 1.0) / 2.0) * max_pow) + 4.0;
     int iters = 0;
-    for (int i = 0; i < MAX_ITERS; i++) {
+    for (int i = 0; i < max_iters; i++) {
         iters = i;
         r = length(z);
         if (r > 2.0)
@@ -76,34 +142,86 @@ float mandelbulb_distance(vec3 point) {
         phi = phi * power;
         z = vec3(sin(phi) * cos(theta), sin(phi) * sin(theta), cos(phi)) * zr + point;
     }
+    escape_iters_taken += float(iters + 1);
     return 0.5 * log(r) * r / dr;
 }
 
-// RAY MARCH FRACTAL TOWARDS DIRECTION
-vec3 ray_march_fractal(vec3 origin, vec3 direction) {
+// RAY MARCH FRACTAL TOWARDS DIRECTION (ALSO RETURNS HIT DEPTH AND STEP COUNT)
+// pixel_cone IS THE WIDTH OF ONE PIXEL PER UNIT OF DISTANCE, 0 DISABLES LOD
+vec3 ray_march_fractal(vec3 origin, vec3 direction, float pixel_cone, out float depth, out float steps) {
     float dist = 0.0;
     float total_dist = 0.0;
+    float power = bulb_power();
     vec3 pos = origin;
-    for (int i = 0; i < MAX_ITERS; i++) {
-        dist = mandelbulb_distance(pos);
-        pos = pos + direction * dist;
-        total_dist += dist;
-        if (dist < EPSILON) {
-            float s = (1.0 + sin(float(i) * COLOR_SCALE + COLOR_OFFSET)) / 2.0 * 2.296 + 2.216;
-            float ao = pow((0.9 - max(float(i) / float(MAX_ITERS), 0.0)), 3.800) + 0.5;
+    depth = MAX_DISTANCE;
+    steps = 0.0;
+
+    // RELAXATION 1.0 IS THE PLAIN SPHERE TRACER
+    float omega = u_relaxation > 0.0 ? u_relaxation : (USE_OVER_RELAXATION ? RELAXATION : 1.0);
+    float step_length = 0.0;
+    float prev_dist = 0.0;
+
+    // START AT THE BOUNDING SPHERE, MISSES RETURN AT ONCE
+    float exit_dist = MAX_DISTANCE;
+    if (u_unbounded == 0) {
+        float b = dot(origin, direction);
+        float c = dot(origin, origin) - BOUND_RADIUS * BOUND_RADIUS;
+        float h = b * b - c;
+        if (h < 0.0 || -b + sqrt(h) < 0.0)
+            return vec3(0.0, 0.0, 0.0);
+        total_dist = max(-b - sqrt(h), 0.0);
+        exit_dist = -b + sqrt(h);
+        pos = origin + direction * total_dist;
+    }
+
+    int max_steps = march_budget(pixel_cone);
+    for (int i = 0; i < max_steps; i++) {
+        // SURFACE EPSILON / ESCAPE BUDGET FOR THE FOOTPRINT AT THIS DISTANCE
+        float footprint = total_dist * pixel_cone * LOD_PIXEL_SCALE;
+        float eps = max(EPSILON, footprint);
+        int max_iters = footprint > EPSILON ? escape_budget(eps, power) : MAX_ITERS;
+
+        dist = mandelbulb_distance(pos, power, max_iters);
+        steps = float(i + 1) / float(MAX_ITERS_MARCH);
+
+        // OVERSHOT: GO BACK AND TAKE THE SAFE STEP, STAY CONSERVATIVE FOR THE REST OF THE RAY
+        if (omega > 1.0 && dist + prev_dist < step_length) {
+            total_dist += prev_dist - step_length;
+            step_length = prev_dist;
+            omega = 1.0;
+            pos = origin + direction * total_dist;
+            continue;
+        }
+
+        step_length = dist * omega;
+        prev_dist = dist;
+        total_dist += step_length;
+        pos = origin + direction * total_dist;
+        if (dist < eps) {
+            depth = total_dist;
+            float s = (1.0 + sin(float(i) * color_scale + color_offset)) / 2.0 * 2.296 + 2.216;
+            float ao = pow((0.9 - max(float(i) / float(MAX_ITERS_MARCH), 0.0)), 3.800) + 0.5;
             return palette(s) * ao;
         }
-        if (total_dist > MAX_DISTANCE) {
+        if (total_dist > exit_dist) {
             break;
         }
     }
     return vec3(0.0, 0.0, 0.0);
 }
 
-// RANDOM 0-1 FROM SEED
-float rand(vec2 seed)
+// PER PIXEL 0-1 OFFSET (INTERLEAVED GRADIENT NOISE, BLUE-NOISE LIKE)
+float pixel_noise(vec2 pixel)
+{
+    return fract(52.9829189 * fract(dot(pixel, vec2(0.06711056, 0.00583715))));
+}
+
+// LOW DISCREPANCY 0-1 POINT i (R2 SEQUENCE) ROTATED BY A PER PIXEL OFFSET
+vec2 aperture_sample(int i, vec2 pixel)
 {
-    return fract(sin(dot(seed.xy, vec2(12.9898, 78.233))) * 43758.5453);
+    vec2 r2 = vec2(0.7548776662, 0.5698402910) * float(i + 1);
+    float offset = pixel_noise(pixel);
+    return fract(r2 + vec2(offset, fract(offset * 1.618034)));
 }
 
 // GET ANGLE AND AXIS FROM 2 VECTORS
@@ -141,6 +259,33 @@ void main()
     vec3 center = vec3(cos(-1.592) * look_size, 0.0, sin(-1.592) * look_size);
     vec3 cam_pos = vec3(size * cos(t), 0.0, size * sin(t)) + center;
 
+    if (u_sweep > 0) {
+        // FIND THE TILE (INDEX 0 AT THE TOP LEFT) AND THE UV INSIDE IT
+        ivec2 tile_size = ivec2(u_resolution);
+        ivec2 tile = ivec2(gl_FragCoord.xy) / tile_size;
+        int index = (u_sweep_grid.y - 1 - tile.y) * u_sweep_grid.x + tile.x;
+        if (index < 0 || index >= u_sweep || tile.x >= u_sweep_grid.x) {
+            color = vec4(0.0, 0.0, 0.0, 1.0);
+            guide = vec4(MAX_DISTANCE, 0.0, 0.0, 1.0);
+            return;
+        }
+        uv = (gl_FragCoord.xy - vec2(tile * tile_size)) / vec2(tile_size) * 2.0 - 1.0;
+
+        // LOAD THE TILE PARAMETERS
+        vec4 texel_a = texelFetch(u_sweep_params, ivec2(0, index), 0);
+        vec4 texel_b = texelFetch(u_sweep_params, ivec2(1, index), 0);
+        vec4 texel_c = texelFetch(u_sweep_params, ivec2(2, index), 0);
+        color_a = texel_a.rgb;
+        color_b = texel_b.rgb;
+        color_c = texel_c.rgb;
+        color_d = texelFetch(u_sweep_params, ivec2(3, index), 0).rgb;
+        color_scale = texel_a.a;
+        color_offset = texel_b.a;
+        sweep_power = texel_c.a;
+        cam_pos = texelFetch(u_sweep_params, ivec2(4, index), 0).xyz;
+        center = texelFetch(u_sweep_params, ivec2(5, index), 0).xyz;
+    }
+
     // GET FOV PIXEL COORDS
     float fovRad = FOV * (3.141 / 180.0);
     float tanHalfFov = tan(fovRad * 0.5);
@@ -159,16 +304,24 @@ void main()
     
     // GET FOCUS DISTANCE
     float focus_distance = length(center - cam_pos) * FOCAL_LENGTH;
+
+    // GET PIXEL FOOTPRINT (uv SPANS 2 OVER THE FRAME HEIGHT)
+    bool use_lod = (USE_LOD || u_lod == 1) && u_exact == 0 && u_resolution.y > 0.0;
+    float pixel_cone = use_lod ? 2.0 * tanHalfFov / u_resolution.y : 0.0;
     
     vec3 out_color = vec3(0.0, 0.0, 0.0);
+    float depth = 0.0;
+    float steps = 0.0;
 
     if (USE_DOF) {
+        // SAMPLE COUNT FROM THE HOST (DENOISED RENDERS USE FAR FEWER)
+        int num_samples = u_samples > 0 ? u_samples : NUM_SAMPLES;
+
         vec3 dof_color = vec3(0.0, 0.0, 0.0);
-        for (int i = 0; i < NUM_SAMPLES; i++) {
+        for (int i = 0; i < num_samples; i++) {
             // GENERATE SAMPLE
-            float randX = (2.0 * rand(uv.xy + vec2(cos(float(i)), sin(float(i))))) - 1.0;
-            float randY = (2.0 * rand(uv.xy - vec2(sin(float(i)), cos(float(i))))) - 1.0;
-            vec3 aperture_offset = vec3(randX, randY, 0.0) * APERTURE;
+            vec2 jitter = aperture_sample(i, gl_FragCoord.xy) * 2.0 - 1.0;
+            vec3 aperture_offset = vec3(jitter, 0.0) * APERTURE;
 
             // NEW ORIGIN / DIRECTION
             vec3 new_cam_pos = cam_pos + aperture_offset;
@@ -176,19 +329,31 @@ void main()
             vec3 new_direction = normalize(focal_point - new_cam_pos);
 
             // CALCULATE SAMPL<E
-            vec3 sampleColor = ray_march_fractal(new_cam_pos, new_direction);
+            float sample_depth;
+            float sample_steps;
+            vec3 sampleColor = ray_march_fractal(new_cam_pos, new_direction, pixel_cone, sample_depth, sample_steps);
 
             // ACCUMULATE COLOR
             dof_color = dof_color + sampleColor;
+            depth += sample_depth;
+            steps += sample_steps;
         }
         // GET AVERAGE COLOR
-        dof_color = dof_color / float(NUM_SAMPLES);
+        dof_color = dof_color / float(num_samples);
+        depth /= float(num_samples);
+        steps /= float(num_samples);
         out_color = dof_color;
+        escape_iters_taken /= float(num_samples);
     }
     else {
-        out_color = ray_march_fractal(cam_pos, direction);
+        out_color = ray_march_fractal(cam_pos, direction, pixel_cone, depth, steps);
     }
 
-    // OUTPUT COLOR
+    // OUTPUT COLOR AND DENOISER GUIDE
     color = vec4(out_color, 1.0);
+    guide = vec4(depth, steps, 0.0, 1.0);
+
+    // OUTPUT RAW MARCH STEPS / ESCAPE ITERATIONS PER RAY INSTEAD
+    if (u_heatmap == 1)
+        color = vec4(steps * float(MAX_ITERS_MARCH), escape_iters_taken, 0.0, 1.0);
 }
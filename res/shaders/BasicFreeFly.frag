@@ -22,12 +22,26 @@ uniform vec2 u_resolution;
 uniform vec3 u_campos;
 uniform vec3 u_camdir;
 uniform float u_fov;
+uniform int u_exact;
+uniform int u_unbounded;
 
 #define MAX_ITERS 500
 #define MAX_ITERS_MARCH 500
 #define EPSILON 0.0001
 #define MAX_DISTANCE 100.0
 
+// EVERY POINT OUTSIDE THIS RADIUS ESCAPES ON THE FIRST ITERATION (r > 2.0)
+#define BOUND_RADIUS 2.0
+
+// LOD: HIT EPSILON FOLLOWS THE PIXEL FOOTPRINT, ESCAPE ITERATIONS FOLLOW EPSILON ONCE IT
+// IS ABOVE EPSILON, MARCH STEPS FOLLOW THE FOOTPRINT (OFF UNTIL CHECKED WITH THE HEATMAP)
+#define USE_LOD false
+#define LOD_PIXEL_SCALE 0.5
+#define LOD_ITERS_SCALE 2.0
+#define LOD_ITERS_MARGIN 8.0
+#define LOD_STEPS_SCALE 16.0
+#define LOD_STEPS_MARGIN 64.0
+
 #define TIME_SCALE 1.0
 #define TIME_OFFSET 5.616
 
@@ -61,14 +75,34 @@ vec3 palette(float t) {
     return a + b*cos(6.28318*(c*t+d));
 }
 
+// MANDEL BULB POWER
+float bulb_power() {
+    float max_pow = 11.640;
+    return u_mouse.z / 50.0f + 1.1;//(((sin(u_time * 0.132 * TIME_SCALE + TIME_OFFSET) + 1.0) / 2.0) * max_pow) + 4.0;
+}
+
+// ESCAPE ITERATIONS NEEDED TO RESOLVE THE SURFACE TO WITHIN eps
+int escape_budget(float eps, float power) {
+    float needed = LOD_ITERS_MARGIN + LOD_ITERS_SCALE * log(1.0 / eps) / log(power);
+    return min(int(needed), MAX_ITERS);
+}
+
+// MARCH STEPS NEEDED TO CLOSE IN ON THE SURFACE TO THE PIXEL FOOTPRINT
+// Each step shrinks the remaining distance by a roughly constant factor,
+// so the count grows with the log of distance over footprint
+int march_budget(float pixel_cone) {
+    if (pixel_cone <= 0.0)
+        return MAX_ITERS_MARCH;
+    float needed = LOD_STEPS_MARGIN + LOD_STEPS_SCALE * log(1.0 / (pixel_cone * LOD_PIXEL_SCALE));
+    return min(int(needed), MAX_ITERS_MARCH);
+}
+
 // MANDEL BULB SIGNED DISTANCE FUNCTION
-float mandelbulb_distance(vec3 point) {
+float mandelbulb_distance(vec3 point, float power, int max_iters) {
     vec3 z = point;
     float dr = 1.0;
     float r = 0.0;
-    float max_pow = 11.640;
-    float power = u_mouse.z / 50.0f + 1.1;//(((sin(u_time * 0.132 * TIME_SCALE + TIME_OFFSET) + 1.0) / 2.0) * max_pow) + 4.0;
-    for (int i = 0; i < MAX_ITERS; i++) {
+    for (int i = 0; i < max_iters; i++) {
         r = length(z);
         if (r > 2.0)
             break;
@@ -84,20 +118,42 @@ float mandelbulb_distance(vec3 point) {
 }
 
 // RAY MARCH FRACTAL TOWARDS DIRECTION
-vec3 ray_march_fractal(vec3 origin, vec3 direction) {
+// pixel_cone IS THE WIDTH OF ONE PIXEL PER UNIT OF DISTANCE, 0 DISABLES LOD
+vec3 ray_march_fractal(vec3 origin, vec3 direction, float pixel_cone) {
     float dist = 0.0;
     float total_dist = 0.0;
+    float power = bulb_power();
     vec3 pos = origin;
-    for (int i = 0; i < MAX_ITERS_MARCH; i++) {
-        dist = mandelbulb_distance(pos);
+
+    // START AT THE BOUNDING SPHERE, MISSES RETURN AT ONCE
+    float exit_dist = MAX_DISTANCE;
+    if (u_unbounded == 0) {
+        float b = dot(origin, direction);
+        float c = dot(origin, origin) - BOUND_RADIUS * BOUND_RADIUS;
+        float h = b * b - c;
+        if (h < 0.0 || -b + sqrt(h) < 0.0)
+            return vec3(0.0, 0.0, 0.0);
+        total_dist = max(-b - sqrt(h), 0.0);
+        exit_dist = -b + sqrt(h);
+        pos = origin + direction * total_dist;
+    }
+
+    int max_steps = march_budget(pixel_cone);
+    for (int i = 0; i < max_steps; i++) {
+        // SURFACE EPSILON / ESCAPE BUDGET FOR THE FOOTPRINT AT THIS DISTANCE
+        float footprint = total_dist * pixel_cone * LOD_PIXEL_SCALE;
+        float eps = max(EPSILON, footprint);
+        int max_iters = footprint > EPSILON ? escape_budget(eps, power) : MAX_ITERS;
+
+        dist = mandelbulb_distance(pos, power, max_iters);
         total_dist += dist;
         pos = origin + direction * total_dist;
-        if (dist < EPSILON) {
+        if (dist < eps) {
             float s = (1.0 + sin(float(i) * COLOR_SCALE + COLOR_OFFSET)) / 2.0 * 2.296 + 2.216;
             float ao = pow((0.9 - max(float(i) / float(MAX_ITERS_MARCH), 0.0)), 3.800) + 0.5;
             return palette(s) * ao;
         }
-        if (total_dist > MAX_DISTANCE) {
+        if (total_dist > exit_dist) {
             break;
         }
     }
@@ -163,6 +219,10 @@ void main()
     
     // GET FOCUS DISTANCE
     float focus_distance = length(center - cam_pos) * FOCAL_LENGTH;
+
+    // GET PIXEL FOOTPRINT (uv SPANS 2 OVER THE FRAME HEIGHT)
+    bool use_lod = USE_LOD && u_exact == 0 && u_resolution.y > 0.0;
+    float pixel_cone = use_lod ? 2.0 * tanHalfFov / u_resolution.y : 0.0;
     
     vec3 out_color = vec3(0.0, 0.0, 0.0);
 
@@ -180,7 +240,7 @@ void main()
             vec3 new_direction = normalize(focal_point - new_cam_pos);
 
             // CALCULATE SAMPL<E
-            vec3 sampleColor = ray_march_fractal(new_cam_pos, new_direction);
+            vec3 sampleColor = ray_march_fractal(new_cam_pos, new_direction, pixel_cone);
 
             // ACCUMULATE COLOR
             dof_color = dof_color + sampleColor;
@@ -190,7 +250,7 @@ void main()
         out_color = dof_color;
     }
     else {
-        out_color = ray_march_fractal(cam_pos, direction);
+        out_color = ray_march_fractal(cam_pos, direction, pixel_cone);
     }
 
     // OUTPUT COLOR
@@ -0,0 +1,64 @@
+#shader vertex
+#version 330 core
+
+layout(location = 0) in vec4 position;
+out vec2 fragPosition;
+
+void main()
+{
+    gl_Position = position;
+    fragPosition = position.xy;
+};
+
+#shader fragment
+#version 330 core
+
+layout(location = 0) out vec4 color;
+in vec2 fragPosition;
+
+// NOISY COLOR (OR PREVIOUS PASS) AND GUIDE (x = HIT DEPTH, y = MARCH STEPS)
+uniform sampler2D u_color;
+uniform sampler2D u_guide;
+uniform int u_step_width;
+
+#define SIGMA_COLOR 0.35
+#define SIGMA_DEPTH 0.02
+#define SIGMA_STEPS 0.08
+
+// ONE EDGE-AVOIDING A-TROUS PASS (5x5 B3 SPLINE, HOLES OF u_step_width PIXELS)
+void main()
+{
+    ivec2 size = textureSize(u_color, 0);
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+
+    float kernel[3] = float[](3.0 / 8.0, 1.0 / 4.0, 1.0 / 16.0);
+
+    vec3 center_color = texelFetch(u_color, pixel, 0).rgb;
+    vec2 center_guide = texelFetch(u_guide, pixel, 0).xy;
+
+    // Color tolerance shrinks with every pass so later passes only smooth noise
+    float sigma_color = SIGMA_COLOR / float(u_step_width);
+
+    vec3 sum = vec3(0.0);
+    float weight_sum = 0.0;
+
+    for (int y = -2; y <= 2; y++) {
+        for (int x = -2; x <= 2; x++) {
+            ivec2 tap = clamp(pixel + ivec2(x, y) * u_step_width, ivec2(0), size - 1);
+
+            vec3 tap_color = texelFetch(u_color, tap, 0).rgb;
+            vec2 tap_guide = texelFetch(u_guide, tap, 0).xy;
+
+            vec3 color_delta = tap_color - center_color;
+            float color_weight = exp(-dot(color_delta, color_delta) / (sigma_color * sigma_color));
+            float depth_weight = exp(-abs(tap_guide.x - center_guide.x) / (SIGMA_DEPTH * max(center_guide.x, 1.0)));
+            float steps_weight = exp(-abs(tap_guide.y - center_guide.y) / SIGMA_STEPS);
+
+            float weight = kernel[abs(x)] * kernel[abs(y)] * color_weight * depth_weight * steps_weight;
+            sum += tap_color * weight;
+            weight_sum += weight;
+        }
+    }
+
+    color = vec4(sum / weight_sum, 1.0);
+}